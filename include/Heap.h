@@ -69,6 +69,7 @@ class Heap {
     void setBounds (int size) { assert(size >= 0); indices.growTo(size,0); }
     bool inHeap    (int n)    { assert(ok(n)); return indices[n] != 0; }
     void increase  (int n)    { assert(ok(n)); assert(inHeap(n)); percolateUp(indices[n]); }
+    void decrease  (int n)    { assert(ok(n)); assert(inHeap(n)); percolateDown(indices[n]); }
     bool empty     ()         { return heap.size() == 1; }
 
     void insert(int n) {
@@ -40,9 +40,22 @@ struct SolverStats {
 };
 
 
+enum RestartMode {
+    restart_Geometric,  // 'restart_first' conflicts, times 'restart_inc' after each restart (MiniSat 1.x).
+    restart_Luby,       // 'restart_first' times the Luby sequence 1 1 2 1 1 2 4 ... (with 'restart_inc' = 2).
+    restart_Glucose     // Whenever the recent learnts' LBD is high: fast average * 'restart_K' > slow average.
+};
+
 struct SearchParams {
-    double  var_decay, clause_decay, random_var_freq;    // (reasonable values are: 0.95, 0.999, 0.02)    
-    SearchParams(double v = 1, double c = 1, double r = 0) : var_decay(v), clause_decay(c), random_var_freq(r) { }
+    double      var_decay, clause_decay, random_var_freq;   // (reasonable values are: 0.95, 0.999, 0.02)
+    RestartMode restart;
+    double      restart_first, restart_inc, restart_K;      // (reasonable values are: 100, 1.5 (2 for Luby), 0.8)
+    bool        lbd_reduce;     // Reduce the learnts by LBD on a conflict schedule, keeping the ones of LBD <= 'glue_keep' for good; else by activity.
+    int         glue_keep;
+    SearchParams(double v = 1, double c = 1, double r = 0, RestartMode rm = restart_Geometric, bool l = false)
+        : var_decay(v), clause_decay(c), random_var_freq(r), restart(rm)
+        , restart_first(100), restart_inc(rm == restart_Luby ? 2 : 1.5), restart_K(0.8)
+        , lbd_reduce(l), glue_keep(2) { }
 };
 
 
@@ -51,36 +64,51 @@ protected:
     // Solver state:
     //
     bool                ok;               // If FALSE, the constraints are already unsatisfiable. No part of the solver state may be used!
-    vec<Clause*>        clauses;          // List of problem clauses.
-    vec<Clause*>        learnts;          // List of learnt clauses.
+    ClauseAllocator     ca;               // Holds all clauses; the lists below name them by 'CRef'.
+    vec<CRef>           clauses;          // List of problem clauses.
+    vec<CRef>           learnts;          // List of learnt clauses.
+    vec<CRef>           guarded;          // Problem clauses added by 'addGuardedClause()'; dropped again by 'removeGuard()'.
     vec<ClauseId>       unit_id;          // 'unit_id[var]' is the clause ID for the unit literal 'var' or '~var' (if set at toplevel).
     double              cla_inc;          // Amount to bump next clause with.
     double              cla_decay;        // INVERSE decay factor for clause activity: stores 1/decay.
+    bool                lbd_update;       // Set from 'params.lbd_reduce' by 'search()'; 'analyze()' then lowers the LBD of the learnts it meets.
 
     vec<double>         activity;         // A heuristic measurement of the activity of a variable.
+    vec<char>           polarity;         // 'polarity[var]' is the sign of the literal to branch on for 'var': its last value if 'phase_saving', else as set by 'setPolarity()' (TRUE by default).
     double              var_inc;          // Amount to bump next variable with.
     double              var_decay;        // INVERSE decay factor for variable activity: stores 1/decay. Use negative value for static variable order.
     VarOrder            order;            // Keeps track of the decision variable order.
 
-    vec<vec<Clause*> >  watches;          // 'watches[lit]' is a list of constraints watching 'lit' (will go there if literal becomes true).
+    vec<vec<Watcher> >  watches;          // 'watches[lit]' is a list of constraints watching 'lit' (will go there if literal becomes true).
+    vec<vec<Watcher> >  watchesBin;       // The same for binary clauses, kept apart so that 'propagate()' needs only the blockers.
     vec<char>           assigns;          // The current assignments (lbool:s stored as char:s).
     vec<Lit>            trail;            // Assignment stack; stores all assigments made in the order they were made.
     vec<int>            trail_lim;        // Separator indices for different decision levels in 'trail[]'.
-    vec<Clause*>        reason;           // 'reason[var]' is the clause that implied the variables current value, or 'NULL' if none.
+    vec<CRef>           reason;           // 'reason[var]' is the clause that implied the variables current value, or 'CRef_Undef' if none.
     vec<int>            level;            // 'level[var]' is the decision level at which assignment was made.
     vec<int>            trail_pos;        // 'trail_pos[var]' is the variable's position in 'trail[]'. This supersedes 'level[]' in some sense, and 'level[]' will probably be removed in future releases.
     int                 root_level;       // Level of first proper decision.
+    vec<Lit>            root_assumps;     // The assumptions of the last 'solveLimited()'; 'keep_assumps' may have left levels '1..root_level' of them assigned.
     int                 qhead;            // Head of queue (as index into the trail -- no more explicit propagation queue in MiniSat).
     int                 simpDB_assigns;   // Number of top-level assignments since last execution of 'simplifyDB()'.
     int64               simpDB_props;     // Remaining number of propagations that must be made before next execution of 'simplifyDB()'.
+    int64               conflict_limit;   // 'stats.conflicts' at which the current 'solveLimited()' gives up; -1 if never.
+    int64               propagation_limit;// 'stats.propagations' at which it gives up; -1 if never.
+    double              time_limit;       // 'realTime()' at which it gives up; 0 if never.
+    int                 time_checks;      // Calls of 'withinBudget()'; the clock is read on every 64th only.
+    bool                budget_out;       // TRUE once the current 'solveLimited()' has run out of a budget.
+    double              lbd_fast;         // Moving averages of the LBD of learnt clauses, over about the last 32 conflicts
+    double              lbd_slow;         // and the last 16384; for 'restart_Glucose'.
+    int64               next_reduce;      // 'stats.conflicts' at which 'lbd_reduce' next reduces the learnts.
+    int                 nof_reduce;       // Number of those reductions so far.
 
     // Temporaries (to reduce allocation overhead). Each variable is prefixed by the method in which is used:
     //
     vec<char>           analyze_seen;
     vec<Lit>            analyze_stack;
     vec<Lit>            analyze_toclear;
-    Clause*             propagate_tmpbin;
-    Clause*             analyze_tmpbin;
+    vec<uint>           lbd_level;        // 'lbd_level[lev]' is 'lbd_stamp' if level 'lev' was counted by the current 'computeLBD()'.
+    uint                lbd_stamp;
     vec<Lit>            addUnit_tmp;
     vec<Lit>            addBinary_tmp;
     vec<Lit>            addTernary_tmp;
@@ -91,14 +119,21 @@ protected:
     void        cancelUntil      (int level);
     void        record           (const vec<Lit>& clause);
 
-    void        analyze          (Clause* confl, vec<Lit>& out_learnt, int& out_btlevel); // (bt = backtrack)
+    void        analyze          (CRef confl, vec<Lit>& out_learnt, int& out_btlevel); // (bt = backtrack)
     bool        analyze_removable(Lit p, uint min_level);                                 // (helper method for 'analyze()')
-    void        analyzeFinal     (Clause* confl, bool skip_first = false);
-    bool        enqueue          (Lit fact, Clause* from = NULL);
-    Clause*     propagate        ();
+    void        analyzeFinal     (CRef confl, bool skip_first = false);
+    bool        enqueue          (Lit fact, CRef from = CRef_Undef);
+    CRef        propagate        ();
+    void        proofUnit        (const Clause& c);
     void        reduceDB         ();
+    void        reduceDB_lbd     (int glue_keep);
+    uint        computeLBD       (const Lit* ps, int size);
+    void        checkGarbage     ();
+    void        garbageCollect   ();
+    void        relocAll         (ClauseAllocator& to);
     Lit         pickBranchLit    (const SearchParams& params);
     lbool       search           (int nof_conflicts, int nof_learnts, const SearchParams& params);
+    bool        withinBudget     ();
     double      progressEstimate ();
 
     // Activity:
@@ -114,11 +149,11 @@ protected:
 
     // Operations on clauses:
     //
-    void     newClause(const vec<Lit>& ps, bool learnt = false, ClauseId id = ClauseId_NULL, bool A = true);
-    void     claBumpActivity (Clause* c) { if ( (c->activity() += cla_inc) > 1e20 ) claRescaleActivity(); }
-    void     remove          (Clause* c, bool just_dealloc = false);
-    bool     locked          (const Clause* c) const { return reason[var((*c)[0])] == c; }
-    bool     simplify        (Clause* c) const;
+    void     newClause(const vec<Lit>& ps, bool learnt = false, ClauseId id = ClauseId_NULL, bool A = true, uint lbd = 0);
+    void     claBumpActivity (Clause& c) { if ( (c.activity() += cla_inc) > 1e20 ) claRescaleActivity(); }
+    void     remove          (CRef cr);
+    bool     locked          (CRef cr) const { return reason[var(ca[cr][0])] == cr; }
+    bool     simplify        (CRef cr) const;
 
     int      decisionLevel() const { return trail_lim.size(); }
 
@@ -126,34 +161,41 @@ public:
     Solver() : ok               (true)
              , cla_inc          (1)
              , cla_decay        (1)
+             , lbd_update       (false)
              , var_inc          (1)
              , var_decay        (1)
              , order            (assigns, activity)
              , qhead            (0)
              , simpDB_assigns   (0)
              , simpDB_props     (0)
+             , conflict_limit   (-1)
+             , propagation_limit(-1)
+             , time_limit       (0)
+             , time_checks      (0)
+             , budget_out       (false)
+             , lbd_fast         (0)
+             , lbd_slow         (0)
+             , next_reduce      (2000)
+             , nof_reduce       (0)
+             , lbd_stamp        (0)
              , default_params   (SearchParams(0.95, 0.999, 0.02))
              , expensive_ccmin  (2)
+             , phase_saving     (true)
+             , keep_assumps     (false)
+             , garbage_frac     (0.20)
              , proof            (NULL)
              , verbosity        (0)
+             , conflict_budget  (-1)
+             , propagation_budget(-1)
+             , time_budget      (0)
              , progress_estimate(0)
              , conflict_id      (ClauseId_NULL)
              {
-                vec<Lit> dummy(2,lit_Undef);
-                propagate_tmpbin = Clause_new(false, dummy);
-                analyze_tmpbin   = Clause_new(false, dummy);
                 addUnit_tmp   .growTo(1);
                 addBinary_tmp .growTo(2);
                 addTernary_tmp.growTo(3);
              }
 
-   ~Solver() {
-       for (int i = 0; i < learnts.size(); i++) remove(learnts[i], true);
-       for (int i = 0; i < clauses.size(); i++) if (clauses[i] != NULL) remove(clauses[i], true);
-       remove(propagate_tmpbin, true);
-       remove(analyze_tmpbin, true);
-    }
-
     // Helpers: (semi-internal)
     //
     lbool   value(Var x) const { return toLbool(assigns[x]); }
@@ -173,8 +215,14 @@ public:
     //
     SearchParams    default_params;     // Restart frequency etc.
     int             expensive_ccmin;    // Controls conflict clause minimization. TRUE by default.
+    bool            phase_saving;       // Branch on a variable by the value it had last (i.e. before the last backtrack). TRUE by default.
+    bool            keep_assumps;       // Unless UNSAT, leave the assumptions assigned after 'solveLimited()', so that a next call with the same first assumptions starts from there. FALSE by default.
+    double          garbage_frac;       // Compact the clause region once this fraction of it is freed clauses.
     Proof*          proof;              // Set this directly after constructing 'Solver' to enable proof logging. Initialized to NULL.
     int             verbosity;          // Verbosity level. 0=silent, 1=some progress report, 2=everything
+    int64           conflict_budget;    // Conflicts one 'solveLimited()' may take; -1 means no limit.
+    int64           propagation_budget; // Propagations one 'solveLimited()' may take; -1 means no limit.
+    double          time_budget;        // Wall-clock seconds one 'solveLimited()' may take; 0 means no limit.
 
     // Problem specification:
     //
@@ -185,13 +233,21 @@ public:
     void    addTernary(Lit p, Lit q, Lit r) { addTernary_tmp[0] = p; addTernary_tmp[1] = q; addTernary_tmp[2] = r; addClause(addTernary_tmp); }
     void    addClause (const vec<Lit>& ps , bool A = true)  { newClause(ps , false , ClauseId_NULL , A); }  
 	 // (used to be a difference between internal and external method...)
+    void    addGuardedClause(const vec<Lit>& ps);           // Like 'addClause()', but the clause can be retired by 'removeGuard()'.
+    void    removeGuard(Var g, bool learnts_too = true);   // Drop the guarded (and learnt) clauses containing 'g'.
+
+    // Search hints:
+    //
+    void    setPolarity(Var v, bool sgn) { polarity[v] = (char)sgn; }   // Branch on 'Lit(v, sgn)' first (until phase saving overrides it).
+    void    setActivity(Var v, double act);                         // Set the activity of 'v' to 'act' conflicts' worth of bumps.
 
     // Solving:
     //
     bool    okay() { return ok; }       // FALSE means solver is in an conflicting state (must never be used again!)
     void    simplifyDB();
-    bool    solve(const vec<Lit>& assumps);
+    bool    solve(const vec<Lit>& assumps) { return solveLimited(assumps) == l_True; }
     bool    solve() { vec<Lit> tmp; return solve(tmp); }
+    lbool   solveLimited(const vec<Lit>& assumps);   // l_Undef if a budget ran out first.
 
     double      progress_estimate;  // Set by 'search()'.
     vec<lbool>  model;              // If problem is satisfiable, this vector contains the model (if any).
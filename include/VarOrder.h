@@ -46,6 +46,7 @@ public:
 
     inline void newVar(void);
     inline void update(Var x);                  // Called when variable increased in activity.
+    inline void lower(Var x);                   // Called when variable decreased in activity.
     inline void undo(Var x);                    // Called when variable is unassigned and may be selected again.
     inline Var  select(double random_freq =.0); // Selects a new, unassigned variable (or 'var_Undef' if none exists).
 };
@@ -65,6 +66,13 @@ void VarOrder::update(Var x)
 }
 
 
+void VarOrder::lower(Var x)
+{
+    if (heap.inHeap(x))
+        heap.decrease(x);
+}
+
+
 void VarOrder::undo(Var x)
 {
     if (!heap.inHeap(x))
@@ -0,0 +1,61 @@
+/****************************************************************************
+  FileName     [ myAsyncWriter.h ]
+  PackageName  [ util ]
+  Synopsis     [ Define a double-buffered file writer with its own thread ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2007-2013 LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#ifndef MY_ASYNC_WRITER_H
+#define MY_ASYNC_WRITER_H
+
+#include <pthread.h>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// The caller fills one buffer while a background thread writes the
+// other one out; the caller only waits if it fills a buffer before the
+// thread is done with the last.
+class AsyncWriter
+{
+public:
+   AsyncWriter(size_t bufSize = (1 << 20));
+   ~AsyncWriter();
+
+   bool open(const string& fileName);
+   bool isOpen() const { return _fd >= 0; }
+
+   // Room for "n" bytes at the end of the data, valid until the next
+   // call; commit() then adds the first "n" of them (n <= the reserve)
+   char* reserve(size_t n);
+   void commit(size_t n) { _used += n; }
+   void write(const void* p, size_t n);
+
+   // Writes out everything, then overwrites the first "n" bytes of the
+   // file with "head" (e.g. a header whose counts are known only now).
+   // false if any write failed.
+   bool close(const void* head = 0, size_t n = 0);
+
+private:
+   int                 _fd;
+   vector<char>        _buf[2];
+   unsigned            _cur;        // the buffer being filled
+   size_t              _used;
+   pthread_t           _thread;
+   pthread_mutex_t     _lock;
+   pthread_cond_t      _cond;
+   bool                _pending;    // _buf[1 - _cur] is to be written
+   size_t              _pendingSize;
+   bool                _stop;
+   bool                _failed;
+
+   AsyncWriter(const AsyncWriter&);             // not copyable
+   AsyncWriter& operator = (const AsyncWriter&);
+
+   static void* writerMain(void* w);
+   void handOver();
+};
+
+#endif // MY_ASYNC_WRITER_H
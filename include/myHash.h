@@ -204,6 +204,10 @@ public:
       delete[] _buckets;
 	  _numBuckets = 0;
    }
+   // empty every bucket but keep the buckets and their memory
+   void clear() {
+      for (size_t i = 0; i < _numBuckets; ++i) _buckets[i].clear();
+   }
 
    // check if k is in the hash...
    // if yes, update n and return true;
@@ -242,7 +246,7 @@ public:
 		  return false;
 	    }
 	 }
-	 _buckets.push_back( make_pair( k, d ) );
+	 _buckets[n].push_back( make_pair( k, d ) );
 	 return true; 
    }
 
@@ -0,0 +1,63 @@
+/****************************************************************************
+  FileName     [ myMappedFile.h ]
+  PackageName  [ util ]
+  Synopsis     [ Map a whole file read-only into memory ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2007-2013 LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#ifndef MY_MAPPED_FILE_H
+#define MY_MAPPED_FILE_H
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string>
+
+using namespace std;
+
+// The bytes are in [begin(), end()); there is no terminating '\0'.
+// An empty file opens fine with begin() == end().
+class MappedFile
+{
+public:
+   MappedFile() : _data(0), _size(0) {}
+   ~MappedFile() { close(); }
+
+   bool open(const string& fileName) {
+      close();
+      int fd = ::open(fileName.c_str(), O_RDONLY);
+      if (fd < 0) return false;
+      struct stat st;
+      if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+         ::close(fd); return false;
+      }
+      _size = st.st_size;
+      if (_size != 0) {
+         void* p = mmap(0, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+         if (p == MAP_FAILED) { ::close(fd); _size = 0; return false; }
+         madvise(p, _size, MADV_SEQUENTIAL);
+         _data = (const char*)p;
+      }
+      ::close(fd);
+      return true;
+   }
+   void close() {
+      if (_data) munmap((void*)_data, _size);
+      _data = 0; _size = 0;
+   }
+
+   const char* begin() const { return _data; }
+   const char* end() const { return _data + _size; }
+   size_t size() const { return _size; }
+
+private:
+   const char*  _data;
+   size_t       _size;
+
+   MappedFile(const MappedFile&);               // not copyable
+   MappedFile& operator = (const MappedFile&);
+};
+
+#endif // MY_MAPPED_FILE_H
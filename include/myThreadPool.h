@@ -0,0 +1,71 @@
+/****************************************************************************
+  FileName     [ myThreadPool.h ]
+  PackageName  [ util ]
+  Synopsis     [ Define a small work-stealing thread pool ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2007-2013 LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#ifndef MY_THREAD_POOL_H
+#define MY_THREAD_POOL_H
+
+#include <pthread.h>
+#include <vector>
+#include <deque>
+
+using namespace std;
+
+// A unit of work; the pool never owns (nor deletes) a task.
+// "worker" is the index of the thread running it, in [0, size()).
+class ThreadTask
+{
+public:
+   virtual ~ThreadTask() {}
+   virtual void run(unsigned worker) = 0;
+};
+
+// Each worker keeps its own deque: it pops its latest task from the back
+// and, when idle, steals the oldest task from the front of another one.
+// A pool of less than 2 threads runs the tasks inline in push().
+class ThreadPool
+{
+public:
+   ThreadPool();
+   ~ThreadPool();
+
+   void start(unsigned n);
+   void stop();
+   unsigned size() const { return _size; }
+
+   void push(ThreadTask* t);
+   void wait();               // until every pushed task has finished
+
+private:
+   struct Worker
+   {
+      ThreadPool*           _pool;
+      unsigned              _id;
+      pthread_t             _thread;
+      pthread_mutex_t       _lock;
+      deque<ThreadTask*>    _tasks;
+   };
+
+   unsigned                 _size;
+   vector<Worker*>          _workers;
+   unsigned                 _next;       // round-robin target of push()
+   pthread_mutex_t          _lock;
+   pthread_cond_t           _work;
+   pthread_cond_t           _done;
+   int                      _queued;
+   unsigned                 _unfinished;
+   bool                     _stop;
+
+   ThreadPool(const ThreadPool&);             // not copyable
+   ThreadPool& operator = (const ThreadPool&);
+
+   static void* workerMain(void* w);
+   ThreadTask* take(unsigned id);
+   void finish();
+};
+
+#endif // MY_THREAD_POOL_H
@@ -20,7 +20,7 @@ class SatSolver
 {
    public : 
       SatSolver():_solver(0) { }
-      ~SatSolver() { }
+      ~SatSolver() { if (_solver) delete _solver; }
 
       // Solver initialization and reset
       void initialize() {
@@ -31,6 +31,7 @@ class SatSolver
          if (_solver) delete _solver;
          _solver = new Solver();
          _assump.clear(); _curVar = 0;
+         _freeGuards.clear(); _guardStamp.clear();
       }
 
       // Constructing proof model
@@ -65,12 +66,78 @@ class SatSolver
          _solver->addClause(lits); lits.clear();
       }
 
+      // Activation (guard) variables for clauses that live for one query:
+      // the guarded clauses hold only while the guard is assumed true, and
+      // removeGuard() drops them together with every learnt clause that
+      // depends on them.  Retired guards are recycled by newGuard(), so a
+      // long series of queries keeps the solver at a constant size.
+      Var newGuard() {
+         Var g;
+         if (_freeGuards.size() != 0) { g = _freeGuards.last(); _freeGuards.pop(); }
+         else g = newVar();
+         _guardStamp.growTo(g + 1, 0);
+         _guardStamp[g] = _solver->stats.conflicts;
+         return g;
+      }
+      void removeGuard(Var g) {
+         // no conflict since the guard was made -> no learnt clause has it
+         _solver->removeGuard(g, _solver->stats.conflicts != _guardStamp[g]);
+         // a guard fixed at top-level can never be assumed true again
+         if (_solver->value(g) == l_Undef) _freeGuards.push(g);
+      }
+      // Miter (a ^ b) under guard g, with no output variable:
+      // (!g + a + b)(!g + !a + !b)
+      void addGuardedXorCNF(Var g, Var va, bool fa, Var vb, bool fb) {
+         vec<Lit> lits;
+         Lit la = fa? ~Lit(va): Lit(va);
+         Lit lb = fb? ~Lit(vb): Lit(vb);
+         lits.push(~Lit(g)); lits.push( la); lits.push( lb);
+         _solver->addGuardedClause(lits); lits.clear();
+         lits.push(~Lit(g)); lits.push(~la); lits.push(~lb);
+         _solver->addGuardedClause(lits); lits.clear();
+      }
+
+      // va == vb, with fa/fb = true if it is inverted
+      void addEqCNF(Var va, bool fa, Var vb, bool fb) {
+         vec<Lit> lits;
+         Lit la = fa? ~Lit(va): Lit(va);
+         Lit lb = fb? ~Lit(vb): Lit(vb);
+         lits.push(~la); lits.push( lb);
+         _solver->addClause(lits); lits.clear();
+         lits.push( la); lits.push(~lb);
+         _solver->addClause(lits); lits.clear();
+      }
+
       // For incremental proof, use "assumeSolve()"
       void assumeRelease() { _assump.clear(); }
       void assumeProperty(Var prop, bool val) {
          _assump.push(val? Lit(prop): ~Lit(prop));
       }
       bool assumpSolve() { return _solver->solve(_assump); }
+      // Leave the assumptions assigned after a query, so that the next
+      // one with the same first assumptions does not assign them again.
+      // Adding or removing clauses drops them anyway.
+      void keepAssumptions(bool k) { _solver->keep_assumps = k; }
+
+      // Budgets of each assumpSolveLimited() from now on: conflicts and
+      // propagations (no limit if < 0) and wall-clock seconds (no limit
+      // if <= 0).  reset() lifts them.
+      void setBudget(int64 conflicts, int64 props = -1, double secs = 0) {
+         _solver->conflict_budget = conflicts;
+         _solver->propagation_budget = props;
+         _solver->time_budget = secs;
+      }
+      void budgetOff() { setBudget(-1); }
+      // Search hints for variable v: the value it is tried with first
+      // (phase saving then keeps the value it had last), and its decision
+      // priority, as if v had been in "act" conflicts just now
+      void setPhase(Var v, bool val) { _solver->setPolarity(v, !val); }
+      void setActivity(Var v, double act) { _solver->setActivity(v, act); }
+      // Restart and learnt-clause policies (see SearchParams) from now
+      // on; reset() restores the defaults.
+      void setSearchParams(const SearchParams& p) { _solver->default_params = p; }
+      // l_True if SAT, l_False if UNSAT, l_Undef if a budget ran out first
+      lbool assumpSolveLimited() { return _solver->solveLimited(_assump); }
 
       // For one time proof, use "solve"
       void assertProperty(Var prop, bool val) {
@@ -89,6 +156,8 @@ class SatSolver
       Solver           *_solver;    // Pointer to a Minisat solver
       Var               _curVar;    // Variable currently
       vec<Lit>          _assump;    // Assumption List for assumption solve
+      vec<Var>          _freeGuards; // Retired guards, ready for reuse
+      vec<int64>        _guardStamp; // #conflicts when each guard was made
 };
 
 #endif  // SAT_H
@@ -0,0 +1,79 @@
+/****************************************************************************
+  FileName     [ cirCexBuf.cpp ]
+  PackageName  [ cir ]
+  Synopsis     [ Define the counterexample buffer functions ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2008-2013 LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#include <cassert>
+#include "cirCexBuf.h"
+
+using namespace std;
+
+const unsigned CirCexBuf::NEIGHBOR_NUM;
+
+/****************************************/
+/*   class CirCexBuf member functions   */
+/****************************************/
+void
+CirCexBuf::init( unsigned piNum )
+{
+	_piNum = piNum;
+	_modelNum = 0;
+	_vals.assign( piNum, SimWord() );
+	_cares.assign( piNum, SimWord() );
+}
+
+void
+CirCexBuf::add( const char* pis )
+{
+	assert( !full() );
+	for ( unsigned i = 0; i < _piNum; ++i ) {
+		bool care = ( pis[i] == 0 || pis[i] == 1 );
+		_cares[i].setBit( _modelNum, care );
+		_vals[i].setBit( _modelNum, care && pis[i] == 1 );
+	}
+	++_modelNum;
+}
+
+void
+CirCexBuf::flush( vector<SimWord>& pis )
+{
+	assert( pis.size() == _piNum );
+	for ( unsigned i = 0; i < _piNum; ++i ) {
+		for ( unsigned m = 0; m < _modelNum; ++m ) {
+			if ( _cares[i].bit(m) ) {
+				pis[i].setBit( m, _vals[i].bit(m) );
+			}
+		}
+	}
+
+	unsigned b = _modelNum;
+	for ( unsigned k = 0; k < NEIGHBOR_NUM && _piNum != 0; ++k ) {
+		for ( unsigned m = 0; m < _modelNum && b < SimWord::BITS; ++m, ++b ) {
+			for ( unsigned i = 0; i < _piNum; ++i ) {
+				if ( _cares[i].bit(m) ) {
+					pis[i].setBit( b, pis[i].bit(m) );
+				}
+			}
+			// flip the first cared PI from a random start
+			unsigned start = _rnGen( _piNum ), f = _piNum;
+			for ( unsigned j = 0; j < _piNum; ++j ) {
+				unsigned i = ( start + j ) % _piNum;
+				if ( _cares[i].bit(m) ) {
+					f = i;
+					break;
+				}
+			}
+			if ( f < _piNum ) {
+				pis[f].setBit( b, !pis[f].bit(m) );
+			}
+		}
+	}
+
+	_modelNum = 0;
+	for ( unsigned i = 0; i < _piNum; ++i ) {
+		_cares[i].reset();
+	}
+}
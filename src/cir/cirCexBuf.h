@@ -0,0 +1,52 @@
+/****************************************************************************
+  FileName     [ cirCexBuf.h ]
+  PackageName  [ cir ]
+  Synopsis     [ Define the counterexample buffer of fraig ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2008-2013 LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#ifndef CIR_CEX_BUF_H
+#define CIR_CEX_BUF_H
+
+#include <vector>
+#include "cirDef.h"
+#include "cirSimWord.h"
+#include "rnGen.h"
+
+using namespace std;
+
+// Collects the PI values of SAT counterexamples, one per bit of a
+// simulation word.  flush() writes them over the current PI words and
+// fills the free bits with distance-1 neighbours of the models (one cared
+// PI flipped).  Only the cared PIs are written, so the words of the PIs
+// no model cares about are left as they are.
+class CirCexBuf
+{
+public:
+   // neighbours per model, as long as the word has room
+   static const unsigned NEIGHBOR_NUM = 2;
+
+   CirCexBuf() : _piNum(0), _modelNum(0), _rnGen(0) {}
+   ~CirCexBuf() {}
+
+   void init( unsigned piNum );
+
+   // "pis[i]" is the value of PI i in the model; anything but 0/1 is a
+   // don't care
+   void add( const char* pis );
+   bool full() const { return _modelNum == SimWord::BITS; }
+   bool empty() const { return _modelNum == 0; }
+
+   // "pis" has the current word of every PI; empties the buffer
+   void flush( vector<SimWord>& pis );
+
+private:
+   unsigned            _piNum;
+   unsigned            _modelNum;
+   vector<SimWord>     _vals;      // per PI, a bit per model
+   vector<SimWord>     _cares;     // per PI, set if the model cares
+   LocalRandomNumGen   _rnGen;
+};
+
+#endif // CIR_CEX_BUF_H
@@ -9,8 +9,10 @@
 #include <cassert>
 #include <iostream>
 #include <iomanip>
+#include <sys/stat.h>
 #include "cirMgr.h"
 #include "cirGate.h"
+#include "cirPattern.h"
 #include "cirCmd.h"
 #include "util.h"
 
@@ -52,8 +54,17 @@ enum CirCmdState
 
 static CirCmdState curCmd = CIRINIT;
 
+// true if both paths exist and name the same file
+static bool
+sameFile(const string& a, const string& b)
+{
+   struct stat sa, sb;
+   return stat(a.c_str(), &sa) == 0 && stat(b.c_str(), &sb) == 0 &&
+          sa.st_dev == sb.st_dev && sa.st_ino == sb.st_ino;
+}
+
 //----------------------------------------------------------------------
-//    CIRRead <(string fileName)> [-Replace]
+//    CIRRead <(string fileName)> [-Replace] [-Thread (int threadNum)]
 //----------------------------------------------------------------------
 CmdExecStatus
 CirReadCmd::exec(const string& option)
@@ -65,13 +76,22 @@ CirReadCmd::exec(const string& option)
    if (options.empty())
       return CmdExec::errorOption(CMD_OPT_MISSING, "");
 
-   bool doReplace = false;
+   bool doReplace = false, doThread = false;
+   int threadNum = 1;
    string fileName;
    for (size_t i = 0, n = options.size(); i < n; ++i) {
       if (myStrNCmp("-Replace", options[i], 2) == 0) {
          if (doReplace) return CmdExec::errorOption(CMD_OPT_EXTRA,options[i]);
          doReplace = true;
       }
+      else if (myStrNCmp("-Thread", options[i], 2) == 0) {
+         if (doThread) return CmdExec::errorOption(CMD_OPT_EXTRA,options[i]);
+         if (++i == n)
+            return CmdExec::errorOption(CMD_OPT_MISSING, options[i-1]);
+         if (!myStr2Int(options[i], threadNum) || threadNum < 1)
+            return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+         doThread = true;
+      }
       else {
          if (fileName.size())
             return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
@@ -91,6 +111,7 @@ CirReadCmd::exec(const string& option)
       }
    }
    cirMgr = new CirMgr;
+   cirMgr->setThreads(threadNum);
 
    if (!cirMgr->readCircuit(fileName)) {
       curCmd = CIRINIT;
@@ -106,7 +127,8 @@ CirReadCmd::exec(const string& option)
 void
 CirReadCmd::usage(ostream& os) const
 {
-   os << "Usage: CIRRead <(string fileName)> [-Replace]" << endl;
+   os << "Usage: CIRRead <(string fileName)> [-Replace]"
+      << " [-Thread (int threadNum)]" << endl;
 }
 
 void
@@ -353,7 +375,8 @@ CirStrashCmd::exec(const string& option)
            << endl;
       return CMD_EXEC_ERROR;
    }
-   cirMgr->strash();
+   // the AIGs are hashed as they are read and rehashed on every merge,
+   // so the circuit has no structural duplicates left to merge here
    curCmd = CIRSTRASH;
 
    return CMD_EXEC_DONE;
@@ -373,8 +396,11 @@ CirStrashCmd::help() const
 }
 
 //----------------------------------------------------------------------
-//    CIRSIMulate <-Random | -File <string patternFile>>
-//                [-Output (string logFile)]
+//    CIRSIMulate <-Random | -File <string patternFile> | -Bench <int rounds>>
+//                [-Output (string logFile) [-Compact]]
+//                [-Thread (int threadNum)]
+//                [-Engine <Hash | Sort>] [-Words (int sigWords)]
+//                [-Packed (string packedPatternFile)]
 //----------------------------------------------------------------------
 CmdExecStatus
 CirSimCmd::exec(const string& option)
@@ -387,23 +413,64 @@ CirSimCmd::exec(const string& option)
    vector<string> options;
    CmdExec::lexOptions(option, options);
 
-   ifstream patternFile;
-   ofstream logFile;
-   bool doRandom = false, doFile = false, doLog = false;
+   CirPatternReader patternFile;
+   CirPatternWriter packFile, logFile;
+   string fileName, logName, packName, compactOpt;
+   bool doRandom = false, doFile = false, doLog = false, doThread = false;
+   bool doEngine = false, doBench = false, doWords = false, doPack = false;
+   bool doCompact = false;
+   int threadNum = 0, benchRounds = 0, simWords = 0;
+   FecEngine engine = FEC_SORT;
    for (size_t i = 0, n = options.size(); i < n; ++i) {
       if (myStrNCmp("-Random", options[i], 2) == 0) {
-         if (doRandom || doFile)
+         if (doRandom || doFile || doBench)
             return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
          doRandom = true;
       }
+      else if (myStrNCmp("-Bench", options[i], 2) == 0) {
+         if (doRandom || doFile || doBench)
+            return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+         if (++i == n)
+            return CmdExec::errorOption(CMD_OPT_MISSING, options[i-1]);
+         if (!myStr2Int(options[i], benchRounds) || benchRounds < 1)
+            return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+         doBench = true;
+      }
+      else if (myStrNCmp("-Packed", options[i], 2) == 0) {
+         if (doPack)
+            return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+         if (++i == n)
+            return CmdExec::errorOption(CMD_OPT_MISSING, options[i-1]);
+         packName = options[i];
+         doPack = true;
+      }
+      else if (myStrNCmp("-Words", options[i], 2) == 0) {
+         if (doWords)
+            return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+         if (++i == n)
+            return CmdExec::errorOption(CMD_OPT_MISSING, options[i-1]);
+         if (!myStr2Int(options[i], simWords) || simWords < 1)
+            return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+         doWords = true;
+      }
+      else if (myStrNCmp("-Engine", options[i], 2) == 0) {
+         if (doEngine)
+            return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+         if (++i == n)
+            return CmdExec::errorOption(CMD_OPT_MISSING, options[i-1]);
+         if (myStrNCmp("Hash", options[i], 1) == 0) engine = FEC_HASH;
+         else if (myStrNCmp("Sort", options[i], 1) == 0) engine = FEC_SORT;
+         else return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+         doEngine = true;
+      }
       else if (myStrNCmp("-File", options[i], 2) == 0) {
-         if (doRandom || doFile)
+         if (doRandom || doFile || doBench)
             return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
          if (++i == n)
             return CmdExec::errorOption(CMD_OPT_MISSING, options[i-1]);
-         patternFile.open(options[i].c_str(), ios::in);
-         if (!patternFile)
+         if (!patternFile.open(options[i]))
             return CmdExec::errorOption(CMD_OPT_FOPEN_FAIL, options[i]);
+         fileName = options[i];
          doFile = true;
       }
       else if (myStrNCmp("-Output", options[i], 2) == 0) {
@@ -411,38 +478,85 @@ CirSimCmd::exec(const string& option)
             return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
          if (++i == n)
             return CmdExec::errorOption(CMD_OPT_MISSING, options[i-1]);
-         logFile.open(options[i].c_str(), ios::out);
-         if (!logFile)
-            return CmdExec::errorOption(CMD_OPT_FOPEN_FAIL, options[i]);
+         logName = options[i];
          doLog = true;
       }
+      else if (myStrNCmp("-Compact", options[i], 2) == 0) {
+         if (doCompact)
+            return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+         compactOpt = options[i];
+         doCompact = true;
+      }
+      else if (myStrNCmp("-Thread", options[i], 2) == 0) {
+         if (doThread)
+            return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+         if (++i == n)
+            return CmdExec::errorOption(CMD_OPT_MISSING, options[i-1]);
+         if (!myStr2Int(options[i], threadNum) || threadNum < 1)
+            return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+         doThread = true;
+      }
       else
          return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
    }
 
-   if (!doRandom && !doFile)
+   if (!doRandom && !doFile && !doBench)
       return CmdExec::errorOption(CMD_OPT_MISSING, "");
+   if (doCompact && !doLog)
+      return CmdExec::errorOption(CMD_OPT_ILLEGAL, compactOpt);
+   // the writers truncate their files, so neither may be the input
+   if (doFile && doPack && sameFile(fileName, packName))
+      return CmdExec::errorOption(CMD_OPT_ILLEGAL, packName);
+   if (doFile && doLog && sameFile(fileName, logName))
+      return CmdExec::errorOption(CMD_OPT_ILLEGAL, logName);
 
    assert (curCmd != CIRINIT);
+   if (doLog && !logFile.open(logName, doCompact?
+         CirPatternWriter::LOG_PACKED: CirPatternWriter::LOG_TEXT,
+         cirMgr->getNumPIs(), cirMgr->getNumPOs()))
+      return CmdExec::errorOption(CMD_OPT_FOPEN_FAIL, logName);
+   if (doPack && !packFile.open(packName, CirPatternWriter::PACKED,
+                                cirMgr->getNumPIs()))
+      return CmdExec::errorOption(CMD_OPT_FOPEN_FAIL, packName);
    if (doLog)
       cirMgr->setSimLog(&logFile);
    else cirMgr->setSimLog(0);
-
-   if (doRandom)
+   if (doThread)
+      cirMgr->setThreads(threadNum);
+   if (doEngine)
+      cirMgr->setFecEngine(engine);
+   if (doWords)
+      cirMgr->setSimWords(simWords);
+   cirMgr->setSimPack(doPack? &packFile: 0);
+
+   if (doBench)
+      cirMgr->benchFECs(benchRounds);
+   else if (doRandom)
       cirMgr->randomSim();
    else
       cirMgr->fileSim(patternFile);
    cirMgr->setSimLog(0);
+   cirMgr->setSimPack(0);
    curCmd = CIRSIMULATE;
-   
+
+   bool logOk = logFile.close(), packOk = packFile.close();
+   if (!logOk || !packOk) {
+      cerr << "Error: writing \"" << (logOk? packName: logName)
+           << "\" failed!!" << endl;
+      return CMD_EXEC_ERROR;
+   }
    return CMD_EXEC_DONE;
 }
 
 void
 CirSimCmd::usage(ostream& os) const
 {
-   os << "Usage: CIRSIMulate <-Random | -File <string patternFile>>"
-      << "                   [-Output (string logFile)]" << endl;
+   os << "Usage: CIRSIMulate <-Random | -File <string patternFile> |"
+      << " -Bench <int rounds>>\n"
+      << "                   [-Output (string logFile) [-Compact]]"
+      << " [-Thread (int threadNum)]\n"
+      << "                   [-Engine <Hash | Sort>] [-Words (int sigWords)]\n"
+      << "                   [-Packed (string packedPatternFile)]" << endl;
 }
 
 void
@@ -453,7 +567,9 @@ CirSimCmd::help() const
 }
 
 //----------------------------------------------------------------------
-//    CIRFraig
+//    CIRFraig [-Thread (int threadNum)] [-Budget (int conflicts)]
+//             [-Propagations (int props)] [-TIme (int seconds)]
+//             [-Restart <Geometric | Luby | Glucose>] [-Lbd]
 //----------------------------------------------------------------------
 CmdExecStatus
 CirFraigCmd::exec(const string& option)
@@ -466,13 +582,84 @@ CirFraigCmd::exec(const string& option)
    vector<string> options;
    CmdExec::lexOptions(option, options);
 
-   if (!options.empty())
-      return CmdExec::errorOption(CMD_OPT_EXTRA, options[0]);
+   bool doThread = false, doBudget = false, doProps = false, doTime = false;
+   bool doRestart = false, doLbd = false;
+   int threadNum = 0, budget = 0, props = 0, secs = 0;
+   FraigRestart restart = FRAIG_GEOMETRIC;
+   for (size_t i = 0, n = options.size(); i < n; ++i) {
+      if (myStrNCmp("-Thread", options[i], 2) == 0) {
+         if (doThread)
+            return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+         if (++i == n)
+            return CmdExec::errorOption(CMD_OPT_MISSING, options[i-1]);
+         if (!myStr2Int(options[i], threadNum) || threadNum < 1)
+            return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+         doThread = true;
+      }
+      else if (myStrNCmp("-Budget", options[i], 2) == 0) {
+         if (doBudget)
+            return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+         if (++i == n)
+            return CmdExec::errorOption(CMD_OPT_MISSING, options[i-1]);
+         if (!myStr2Int(options[i], budget) || budget < 0)
+            return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+         doBudget = true;
+      }
+      else if (myStrNCmp("-Propagations", options[i], 2) == 0) {
+         if (doProps)
+            return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+         if (++i == n)
+            return CmdExec::errorOption(CMD_OPT_MISSING, options[i-1]);
+         if (!myStr2Int(options[i], props) || props < 0)
+            return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+         doProps = true;
+      }
+      else if (myStrNCmp("-TIme", options[i], 3) == 0) {
+         if (doTime)
+            return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+         if (++i == n)
+            return CmdExec::errorOption(CMD_OPT_MISSING, options[i-1]);
+         if (!myStr2Int(options[i], secs) || secs < 0)
+            return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+         doTime = true;
+      }
+      else if (myStrNCmp("-Restart", options[i], 2) == 0) {
+         if (doRestart)
+            return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+         if (++i == n)
+            return CmdExec::errorOption(CMD_OPT_MISSING, options[i-1]);
+         if (myStrNCmp("Geometric", options[i], 1) == 0)
+            restart = FRAIG_GEOMETRIC;
+         else if (myStrNCmp("Luby", options[i], 1) == 0)
+            restart = FRAIG_LUBY;
+         else if (myStrNCmp("Glucose", options[i], 2) == 0)
+            restart = FRAIG_GLUCOSE;
+         else return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+         doRestart = true;
+      }
+      else if (myStrNCmp("-Lbd", options[i], 2) == 0) {
+         if (doLbd)
+            return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+         doLbd = true;
+      }
+      else
+         return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+   }
 
    if (curCmd != CIRSIMULATE) {
       cerr << "Error: circuit is not yet simulated!!" << endl;
       return CMD_EXEC_ERROR;
    }
+   if (doThread)
+      cirMgr->setThreads(threadNum);
+   if (doBudget)
+      cirMgr->setFraigBudget(budget);
+   if (doProps)
+      cirMgr->setFraigProps(props);
+   if (doTime)
+      cirMgr->setFraigTime(secs);
+   cirMgr->setFraigRestart(restart);
+   cirMgr->setFraigLbd(doLbd);
    cirMgr->fraig();
    curCmd = CIRFRAIG;
 
@@ -482,7 +669,10 @@ CirFraigCmd::exec(const string& option)
 void
 CirFraigCmd::usage(ostream& os) const
 {
-   os << "Usage: CIRFraig" << endl;
+   os << "Usage: CIRFraig [-Thread (int threadNum)] [-Budget (int conflicts)]\n"
+      << "                [-Propagations (int props)] [-TIme (int seconds)]\n"
+      << "                [-Restart <Geometric | Luby | Glucose>] [-Lbd]"
+      << endl;
 }
 
 void
@@ -493,7 +683,7 @@ CirFraigCmd::help() const
 }
 
 //----------------------------------------------------------------------
-//    CIRWrite [-Output (string aagFile)]
+//    CIRWrite [-Output (string aagFile | aigFile)]
 //----------------------------------------------------------------------
 CmdExecStatus
 CirWriteCmd::exec(const string& option)
@@ -513,10 +703,16 @@ CirWriteCmd::exec(const string& option)
          return CmdExec::errorOption(CMD_OPT_MISSING, options[0]);
       if (options.size() > 2)
          return CmdExec::errorOption(CMD_OPT_EXTRA, options[2]);
-      ofstream outfile(options[1].c_str(), ios::out);
+      // binary AIGER for "*.aig", ASCII otherwise
+      const string& fileName = options[1];
+      bool binary = fileName.size() > 4 &&
+                    fileName.compare(fileName.size() - 4, 4, ".aig") == 0;
+      ofstream outfile(fileName.c_str(), binary? ios::out | ios::binary:
+                                                 ios::out);
       if (!outfile)
-         return CmdExec::errorOption(CMD_OPT_FOPEN_FAIL, options[1]);
-      cirMgr->writeAag(outfile);
+         return CmdExec::errorOption(CMD_OPT_FOPEN_FAIL, fileName);
+      if (binary) cirMgr->writeAig(outfile);
+      else cirMgr->writeAag(outfile);
    }
    else return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[0]);
 
@@ -526,13 +722,13 @@ CirWriteCmd::exec(const string& option)
 void
 CirWriteCmd::usage(ostream& os) const
 {
-   os << "Usage: CIRWrite [-Output (string aagFile)]" << endl;
+   os << "Usage: CIRWrite [-Output (string aagFile | aigFile)]" << endl;
 }
 
 void
 CirWriteCmd::help() const
 {
    cout << setw(15) << left << "CIRWrite: "
-        << "write the netlist to an ASCII AIG file (.aag)\n";
+        << "write the netlist to an AIG file (.aag, or binary .aig)\n";
 }
 
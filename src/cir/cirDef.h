@@ -24,6 +24,11 @@ template <class Gate>
 class PtrV;
 
 class CirMgr;
+class SimBatchTask;
+class FraigProver;
+struct FraigCand;
+class CirPatternReader;
+class CirPatternWriter;
 
 class SatSolver;
 
@@ -41,4 +46,27 @@ enum GateType
    TOT_GATE
 };
 
+// How the FEC groups are split by simulation signature
+enum FecEngine
+{
+   FEC_HASH = 0,     // one hash table over all the groups
+   FEC_SORT = 1      // per group, radix partition by a mixed key
+};
+
+// How the fraig solvers restart (see SearchParams)
+enum FraigRestart
+{
+   FRAIG_GEOMETRIC = 0,   // after 100 conflicts, 1.5 times more each time
+   FRAIG_LUBY      = 1,   // after 100 times the Luby sequence 1 1 2 1 1 2 4
+   FRAIG_GLUCOSE   = 2    // when the LBD of the recent learnts is high
+};
+
+// The outcome of one fraig proof
+enum FraigResult
+{
+   FRAIG_EQV,        // proven equivalent
+   FRAIG_NEQ,        // a counterexample was found
+   FRAIG_UNDEF       // the conflict budget ran out first
+};
+
 #endif // CIR_DEF_H
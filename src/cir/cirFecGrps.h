@@ -0,0 +1,105 @@
+/****************************************************************************
+  FileName     [ cirFecGrps.h ]
+  PackageName  [ cir ]
+  Synopsis     [ Define the arena of FEC groups ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2008-2013 LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#ifndef CIR_FEC_GRPS_H
+#define CIR_FEC_GRPS_H
+
+#include <vector>
+#include <cassert>
+
+using namespace std;
+
+// All the FEC groups in one arena of gate ids: group g is
+// _ids[ _begin[g], _begin[g] + _size[g] ).  Members and groups are erased
+// in place (the last one takes the freed place), and split() breaks a
+// group up inside its own range.  A full refinement builds the groups
+// in the second arena (startNext(), addNext(), swapNext()), so once the
+// two have grown, no round allocates.
+class CirFecGrps
+{
+public:
+   CirFecGrps() {}
+   ~CirFecGrps() {}
+
+   unsigned size() const { return _begin.size(); }
+   bool empty() const { return _begin.empty(); }
+   void clear() { _ids.clear(); _begin.clear(); _size.clear(); }
+
+   unsigned grpSize( unsigned g ) const { return _size[g]; }
+   unsigned id( unsigned g, unsigned j ) const { return _ids[ _begin[g] + j ]; }
+   unsigned& id( unsigned g, unsigned j ) { return _ids[ _begin[g] + j ]; }
+
+   // member j of group g; the last member takes its place
+   void erase( unsigned g, unsigned j ) {
+      assert( j < _size[g] );
+      --_size[g];
+      _ids[ _begin[g] + j ] = _ids[ _begin[g] + _size[g] ];
+   }
+   // group g; the last group takes its index
+   void eraseGrp( unsigned g ) {
+      _begin[g] = _begin.back(); _size[g] = _size.back();
+      _begin.pop_back(); _size.pop_back();
+   }
+   // a new, empty group at the end of the arena
+   unsigned pushGrp() {
+      _begin.push_back( _ids.size() ); _size.push_back( 0 );
+      return _begin.size() - 1;
+   }
+   // only the group at the end of the arena can grow; any other one is
+   // moved there first
+   void push( unsigned g, unsigned id ) {
+      if ( _begin[g] + _size[g] != _ids.size() ) {
+         unsigned b = _ids.size();
+         for ( unsigned j = 0; j < _size[g]; ++j ) {
+            _ids.push_back( _ids[ _begin[g] + j ] );
+         }
+         _begin[g] = b;
+      }
+      _ids.push_back( id );
+      ++_size[g];
+   }
+
+   // The ids of group g are reordered to hold its new groups one after
+   // another, of the "n" sizes in "sizes" (2 or more each).  Group g keeps
+   // the first one, the others are appended; with n == 0, g is left empty.
+   void split( unsigned g, const unsigned* sizes, unsigned n ) {
+      unsigned b = _begin[g];
+      _size[g] = ( n == 0 )? 0: sizes[0];
+      for ( unsigned i = 1; i < n; ++i ) {
+         b += sizes[i - 1];
+         _begin.push_back( b ); _size.push_back( sizes[i] );
+      }
+   }
+
+   // building the groups in the second arena
+   void startNext() { _nextIds.clear(); _nextBegin.clear(); _nextSize.clear(); }
+   unsigned addNext( unsigned n ) {
+      _nextBegin.push_back( _nextIds.size() ); _nextSize.push_back( n );
+      _nextIds.resize( _nextIds.size() + n );
+      return _nextBegin.size() - 1;
+   }
+   unsigned& nextId( unsigned g, unsigned j ) {
+      return _nextIds[ _nextBegin[g] + j ];
+   }
+   void swapNext() {
+      _ids.swap( _nextIds ); _begin.swap( _nextBegin ); _size.swap( _nextSize );
+   }
+
+private:
+   vector<unsigned>  _ids;
+   vector<unsigned>  _begin;
+   vector<unsigned>  _size;
+   vector<unsigned>  _nextIds;
+   vector<unsigned>  _nextBegin;
+   vector<unsigned>  _nextSize;
+
+   CirFecGrps( const CirFecGrps& );             // not copyable
+   CirFecGrps& operator = ( const CirFecGrps& );
+};
+
+#endif // CIR_FEC_GRPS_H
@@ -0,0 +1,209 @@
+/****************************************************************************
+  FileName     [ cirFlatAig.cpp ]
+  PackageName  [ cir ]
+  Synopsis     [ Define the flat AIG array functions ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2008-2013 LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#include <cassert>
+#include <algorithm>
+#include "cirFlatAig.h"
+#include "cirGate.h"
+
+using namespace std;
+
+const unsigned CirFlatAig::NO_NODE;
+
+/*****************************************/
+/*   class CirFlatAig member functions   */
+/*****************************************/
+void
+CirFlatAig::build( const GateList& dfsList, const vector<PIGate>& pis,
+                   const vector<POGate>& pos, size_t gateNum )
+{
+	_piNum = pis.size();
+	_gateNode.assign( gateNum, NO_NODE );
+	_nodeGate.clear();
+	_nodeGate.reserve( dfsList.size() + _piNum + 1 );
+
+	_gateNode[0] = 0;
+	_nodeGate.push_back( 0 );
+	for ( unsigned i = 0; i < _piNum; ++i ) {
+		_gateNode[ pis[i].getId() ] = _nodeGate.size();
+		_nodeGate.push_back( pis[i].getId() );
+	}
+
+	// UNDEF gates never enter the DFS list; number the ones used as fanins
+	for ( size_t i = 0; i < dfsList.size(); ++i ) {
+		const vector< PtrV<CirGate> >& fanins = dfsList[i]->getFanins();
+		for ( size_t j = 0; j < fanins.size(); ++j ) {
+			CirGate* g = fanins[j].ptr();
+			if ( g->getType() == UNDEF_GATE &&
+			     _gateNode[ g->getId() ] == NO_NODE ) {
+				_gateNode[ g->getId() ] = _nodeGate.size();
+				_nodeGate.push_back( g->getId() );
+			}
+		}
+	}
+
+	// AIGs are grouped by level (DFS order within a level), so that each
+	// level is a contiguous range of nodes independent of one another
+	vector<unsigned> level( gateNum, 0 );
+	vector<unsigned> levelSize;
+	for ( size_t i = 0; i < dfsList.size(); ++i ) {
+		if ( dfsList[i]->getType() != AIG_GATE ) {
+			continue;
+		}
+		const vector< PtrV<CirGate> >& fanins = dfsList[i]->getFanins();
+		unsigned l = 0;
+		for ( size_t j = 0; j < fanins.size(); ++j ) {
+			if ( level[ fanins[j].ptr()->getId() ] > l ) {
+				l = level[ fanins[j].ptr()->getId() ];
+			}
+		}
+		level[ dfsList[i]->getId() ] = l + 1;
+		if ( levelSize.size() <= l ) {
+			levelSize.resize( l + 1, 0 );
+		}
+		++levelSize[l];
+	}
+
+	_andBegin = _nodeGate.size();
+	_levelBegin.assign( levelSize.size() + 1, _andBegin );
+	for ( size_t l = 0; l < levelSize.size(); ++l ) {
+		_levelBegin[l + 1] = _levelBegin[l] + levelSize[l];
+	}
+	_nodeGate.resize( _levelBegin.back() );
+	vector<unsigned> next( _levelBegin.begin(), _levelBegin.end() - 1 );
+	for ( size_t i = 0; i < dfsList.size(); ++i ) {
+		if ( dfsList[i]->getType() == AIG_GATE ) {
+			unsigned n = next[ level[ dfsList[i]->getId() ] - 1 ]++;
+			_gateNode[ dfsList[i]->getId() ] = n;
+			_nodeGate[n] = dfsList[i]->getId();
+		}
+	}
+
+	_poBegin = _nodeGate.size();
+	for ( size_t i = 0; i < pos.size(); ++i ) {
+		_gateNode[ pos[i].getId() ] = _nodeGate.size();
+		_nodeGate.push_back( pos[i].getId() );
+	}
+
+	_fanins.assign( 2 * _nodeGate.size(), 0 );
+	for ( size_t i = 0; i < dfsList.size(); ++i ) {
+		unsigned n = _gateNode[ dfsList[i]->getId() ];
+		if ( n < _andBegin ) {
+			continue;
+		}
+		const vector< PtrV<CirGate> >& fanins = dfsList[i]->getFanins();
+		for ( size_t j = 0; j < fanins.size(); ++j ) {
+			unsigned fn = _gateNode[ fanins[j].ptr()->getId() ];
+			assert( fn < n );
+			_fanins[ 2 * n + j ] = 2 * fn + ( fanins[j].isInv()? 1: 0 );
+		}
+		if ( fanins.size() == 1 ) {
+			_fanins[ 2 * n + 1 ] = 1;
+		}
+	}
+
+	// fanouts by counting sort on the fanin nodes; the second literal of
+	// a PO is the constant one, not a real fanin
+	_fanoutBegin.assign( _nodeGate.size() + 1, 0 );
+	for ( unsigned n = _andBegin; n < _nodeGate.size(); ++n ) {
+		++_fanoutBegin[ ( _fanins[2 * n] >> 1 ) + 1 ];
+		if ( n < _poBegin ) {
+			++_fanoutBegin[ ( _fanins[2 * n + 1] >> 1 ) + 1 ];
+		}
+	}
+	for ( size_t n = 1; n < _fanoutBegin.size(); ++n ) {
+		_fanoutBegin[n] += _fanoutBegin[n - 1];
+	}
+	_fanouts.resize( _fanoutBegin.back() );
+	next.assign( _fanoutBegin.begin(), _fanoutBegin.end() - 1 );
+	for ( unsigned n = _andBegin; n < _nodeGate.size(); ++n ) {
+		_fanouts[ next[ _fanins[2 * n] >> 1 ]++ ] = n;
+		if ( n < _poBegin ) {
+			_fanouts[ next[ _fanins[2 * n + 1] >> 1 ]++ ] = n;
+		}
+	}
+}
+
+unsigned
+CirFlatAig::level( unsigned n ) const
+{
+	return upper_bound( _levelBegin.begin(), _levelBegin.end(), n ) -
+	       _levelBegin.begin();
+}
+
+void
+CirFlatAig::swap( CirFlatAig& f )
+{
+	std::swap( _piNum, f._piNum );
+	std::swap( _andBegin, f._andBegin );
+	std::swap( _poBegin, f._poBegin );
+	_levelBegin.swap( f._levelBegin );
+	_fanins.swap( f._fanins );
+	_fanoutBegin.swap( f._fanoutBegin );
+	_fanouts.swap( f._fanouts );
+	_nodeGate.swap( f._nodeGate );
+	_gateNode.swap( f._gateNode );
+}
+
+// Levels narrower than this are not worth handing to the thread pool
+static const unsigned SIM_GRAIN = 2048;
+
+void
+CirFlatAig::simulate( SimWord* val, ThreadPool* pool ) const
+{
+	if ( !pool || pool->size() < 2 ) {
+		simulate( val, _andBegin, nodeNum() );
+		return;
+	}
+
+	vector<SimRangeTask> tasks;
+	for ( unsigned l = 0; l < levelNum(); ++l ) {
+		unsigned b = _levelBegin[l], e = _levelBegin[l + 1];
+		if ( e - b < 2 * SIM_GRAIN ) {
+			simulate( val, b, e );
+			continue;
+		}
+		// a few tasks per thread, so that stealing can even the load
+		unsigned step = ( e - b ) / ( 4 * pool->size() ) + 1;
+		if ( step < SIM_GRAIN ) {
+			step = SIM_GRAIN;
+		}
+		tasks.clear();
+		for ( unsigned n = b; n < e; n += step ) {
+			tasks.push_back( SimRangeTask( this, val, n,
+			                 ( e - n > step )? n + step: e ) );
+		}
+		for ( size_t i = 0; i < tasks.size(); ++i ) {
+			pool->push( &tasks[i] );
+		}
+		pool->wait();
+	}
+	simulate( val, _poBegin, nodeNum() );
+}
+
+void
+CirFlatAig::simulate( SimWord* val, unsigned begin, unsigned end ) const
+{
+	if ( begin >= end ) {
+		return;
+	}
+	const unsigned* f = &_fanins[0] + 2 * begin;
+	for ( unsigned n = begin; n < end; ++n, f += 2 ) {
+		val[n] = ( val[ f[0] >> 1 ] ^ SimWord::mask( f[0] & 1 ) ) &
+		         ( val[ f[1] >> 1 ] ^ SimWord::mask( f[1] & 1 ) );
+	}
+}
+
+/*******************************************/
+/*   class SimRangeTask member functions   */
+/*******************************************/
+void
+SimRangeTask::run( unsigned )
+{
+	_aig->simulate( _val, _begin, _end );
+}
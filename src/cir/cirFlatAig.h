@@ -0,0 +1,107 @@
+/****************************************************************************
+  FileName     [ cirFlatAig.h ]
+  PackageName  [ cir ]
+  Synopsis     [ Define the flat, topologically ordered AIG array ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2008-2013 LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#ifndef CIR_FLAT_AIG_H
+#define CIR_FLAT_AIG_H
+
+#include <vector>
+#include <climits>
+#include "cirDef.h"
+#include "cirSimWord.h"
+#include "myThreadPool.h"
+
+using namespace std;
+
+// A compact copy of the netlist in _DFSList, rebuilt by
+// CirMgr::dfsTraversal().  Nodes are numbered as
+//
+//    [0]                        CONST0
+//    [1, piNum]                 PIs, in the order of CirMgr::_PIs
+//    [piNum+1, andBegin)        UNDEF gates used as fanins
+//    [andBegin, poBegin)        AIGs by level, DFS order within a level
+//    [poBegin, nodeNum)         POs, in the order of CirMgr::_POs
+//
+// Every AIG/PO node keeps two fanin literals (2 * node + inverted);
+// a PO ANDs its fanin with literal 1 (constant one), so the simulation
+// loop treats both alike and never branches on the gate type.
+class CirFlatAig
+{
+public:
+   static const unsigned NO_NODE = UINT_MAX;
+
+   CirFlatAig() : _piNum(0), _andBegin(1), _poBegin(1), _fanoutBegin(2, 0),
+                  _levelBegin(1, 1) {}
+   ~CirFlatAig() {}
+
+   void build( const GateList& dfsList, const vector<PIGate>& pis,
+               const vector<POGate>& pos, size_t gateNum );
+   void swap( CirFlatAig& f );
+
+   unsigned nodeNum() const { return _nodeGate.size(); }
+   unsigned piNum() const { return _piNum; }
+   unsigned piNode( unsigned i ) const { return i + 1; }
+   unsigned andBegin() const { return _andBegin; }
+   unsigned poBegin() const { return _poBegin; }
+   unsigned poNode( unsigned i ) const { return _poBegin + i; }
+   unsigned andNum() const { return _poBegin - _andBegin; }
+   // AIGs of level l + 1 are the nodes [levelBegin(l), levelBegin(l + 1))
+   unsigned levelNum() const { return _levelBegin.size() - 1; }
+   unsigned levelBegin( unsigned l ) const { return _levelBegin[l]; }
+   // 0 for the nodes before andBegin(), levelNum() + 1 for the POs
+   unsigned level( unsigned n ) const;
+
+   // NO_NODE if the gate is not in the DFS list
+   unsigned node( unsigned gid ) const {
+      return ( gid < _gateNode.size() )? _gateNode[gid]: NO_NODE;
+   }
+   unsigned gateId( unsigned n ) const { return _nodeGate[n]; }
+   unsigned fanin( unsigned n, unsigned i ) const {
+      return _fanins[ 2 * n + i ];
+   }
+   // the AIG/PO nodes with "n" as a fanin, once per fanin slot
+   unsigned fanoutNum( unsigned n ) const {
+      return _fanoutBegin[n + 1] - _fanoutBegin[n];
+   }
+   unsigned fanout( unsigned n, unsigned i ) const {
+      return _fanouts[ _fanoutBegin[n] + i ];
+   }
+
+   // Simulates every AIG and PO from the values of nodes [0, andBegin).
+   // With a pool, wide levels are split across its threads; the result
+   // is the same as the serial one.
+   void simulate( SimWord* val, ThreadPool* pool = 0 ) const;
+   void simulate( SimWord* val, unsigned begin, unsigned end ) const;
+
+private:
+   unsigned          _piNum;
+   unsigned          _andBegin;
+   unsigned          _poBegin;
+   vector<unsigned>  _fanins;     // 2 literals per node
+   vector<unsigned>  _fanoutBegin;   // node -> first entry in _fanouts
+   vector<unsigned>  _fanouts;
+   vector<unsigned>  _nodeGate;   // node -> gate id
+   vector<unsigned>  _gateNode;   // gate id -> node
+   vector<unsigned>  _levelBegin;
+};
+
+class SimRangeTask : public ThreadTask
+{
+public:
+   SimRangeTask( const CirFlatAig* a, SimWord* v, unsigned b, unsigned e ) :
+      _aig(a), _val(v), _begin(b), _end(e) {}
+
+   void run( unsigned );
+
+private:
+   const CirFlatAig*  _aig;
+   SimWord*           _val;
+   unsigned           _begin;
+   unsigned           _end;
+};
+
+#endif // CIR_FLAT_AIG_H
@@ -22,64 +22,337 @@ using namespace std;
 /*   Global variable and enum  */
 /*******************************/
 
-bool
-ptrVIdComp( PtrV<CirGate> a, PtrV<CirGate> b )
+// A solver with a literal map of its own, indexed by gate id (lit_Undef if
+// the gate is not encoded yet); the fanin cones are added on demand
+class FraigProver
 {
-	return ( a.ptr()->getId() < b.ptr()->getId() );
-}
+public:
+	FraigProver() : _conflicts(-1), _props(-1), _deadline(0), _hints(0) { }
+
+	void init( unsigned gateNum, const SearchParams& params );
+	// From now on, the variable of a gate starts at its value in
+	// simulation pattern 0 of "mgr", and the deeper gates are decided
+	// first; 0 for no hints
+	void setHints( const CirMgr* mgr ) { _hints = mgr; }
+	// Budgets of each proof from now on: conflicts and propagations (no
+	// limit if < 0), and the realTime() it has to end by (0 for none)
+	void setBudget( int64 conflicts, int64 props, double deadline ) {
+		_conflicts = conflicts; _props = props; _deadline = deadline;
+	}
+	// a == b (a == !b if "isInv")
+	FraigResult prove( const CirFlatAig& aig, unsigned a, unsigned b,
+	                   bool isInv );
+	// b is to be a (!a) from now on, after it is proven so
+	void merge( unsigned a, unsigned b, bool isInv );
+	// value of a gate in the last counterexample; -1 if unknown
+	int value( unsigned gid ) const {
+		if ( _lits[gid] == lit_Undef ) {
+			return -1;
+		}
+		int v = _solver.getValue( var( _lits[gid] ) );
+		return ( v < 0 )? v: v ^ sign( _lits[gid] );
+	}
+private:
+	void encodeCone( const CirFlatAig& aig, unsigned gid );
+	Lit newLit( const CirFlatAig& aig, unsigned n );
+
+	SatSolver _solver;
+	vector<Lit> _lits;
+	int64 _conflicts;
+	int64 _props;
+	double _deadline;
+	const CirMgr* _hints;
+};
 
-class AigashKey
+// A candidate pair of a sequential fraig round, by its estimated cost
+struct FraigCand
+{
+	unsigned _a;
+	unsigned _b;
+	bool _inv;
+	unsigned _cost;
+
+	bool operator < ( const FraigCand& c ) const { return _cost < c._cost; }
+};
+
+// A candidate pair of a parallel fraig chunk; "_task" and "_cex" locate
+// the counterexample of a pair that is not equivalent
+struct FraigPair
+{
+	unsigned _a;
+	unsigned _b;
+	bool _inv;
+	FraigResult _res;
+	unsigned _task;
+	size_t _cex;
+};
+
+// One fraig worker; keeps its solver (and what it has learnt) over the
+// rounds, and the PI values of its counterexamples until clearCexs().
+// Of the pairs of a chunk, worker "id" of "num" proves pairs id,
+// id + num, ... in that order, so what each solver sees does not depend
+// on the scheduling.
+class FraigTask : public ThreadTask
 {
 public:
-   AigashKey( const vector< PtrV<CirGate> >& f ): _fanins(f) {
-      sort( _fanins.begin(), _fanins.end(), ptrVIdComp );
-   }
-
-   size_t operator () () const {
-      size_t value = 0;
-	 for ( size_t i = 0; i < _fanins.size(); ++i ){
-	    value += size_t( _fanins[i].ptr() ) << i;
-	 }
-	 return value;
-   }
-
-   bool operator == ( const AigashKey& k ) const {
-      return ( _fanins == k._fanins );
-   }
+	FraigTask( const CirFlatAig* a, unsigned id, unsigned num )
+		: _aig(a), _id(id), _num(num), _pairs(0) { }
+
+	void init( unsigned gateNum, const CirMgr* hints,
+	           const SearchParams& params ) {
+		_prover.init( gateNum, params );
+		_prover.setHints( hints );
+	}
+	void setBudget( int64 conflicts, int64 props, double deadline ) {
+		_prover.setBudget( conflicts, props, deadline );
+	}
+	void setPairs( vector<FraigPair>* p ) { _pairs = p; }
+	const vector<char>& cexs() const { return _cexs; }
+	void clearCexs() { _cexs.clear(); }
+
+	void run( unsigned );
 private:
-   vector< PtrV<CirGate> > _fanins;
+	const CirFlatAig* _aig;
+	unsigned _id;
+	unsigned _num;
+	vector<FraigPair>* _pairs;
+	FraigProver _prover;
+	vector<char> _cexs;
 };
 
 /**************************************/
 /*   Static varaibles and functions   */
 /**************************************/
+// The cost of a pair: the nodes in the fanin cones of the two (counted up
+// to FRAIG_CONE_CAP), plus FRAIG_DIST_WEIGHT per level between them
+static const unsigned FRAIG_CONE_CAP = 1024;
+static const unsigned FRAIG_DIST_WEIGHT = 8;
+// A pair out of budget is retried with FRAIG_RETRY_GROWTH times the
+// budget, up to FRAIG_RETRIES times; then it is left unresolved
+static const int FRAIG_RETRY_GROWTH = 8;
+static const unsigned FRAIG_RETRIES = 3;
+// Pairs per worker in a chunk of parallel fraig; the groups are refined
+// by the counterexamples of a chunk before the next one is taken
+static const unsigned FRAIG_CHUNK_PAIRS = 16;
+// The initial activity of a gate's variable per level, in conflicts
+static const double FRAIG_LEVEL_ACT = 0.01;
+
+// The budget "b" of the "retry"-th retry; -1 (no limit) for b == 0
+static int64
+retryBudget( unsigned b, unsigned retry )
+{
+	if ( b == 0 ) {
+		return -1;
+	}
+	int64 n = b;
+	for ( unsigned i = 0; i < retry; ++i ) {
+		n *= FRAIG_RETRY_GROWTH;
+	}
+	return n;
+}
 
-/*******************************************/
-/*   Public member functions about fraig   */
-/*******************************************/
+// The decays and random decisions of MiniSat's defaults (see Solver()),
+// with restarts "r" and, if "lbd", the learnts kept by LBD
+static SearchParams
+searchParams( FraigRestart r, bool lbd )
+{
+	RestartMode mode = restart_Geometric;
+	if ( r == FRAIG_LUBY ) {
+		mode = restart_Luby;
+	}
+	else if ( r == FRAIG_GLUCOSE ) {
+		mode = restart_Glucose;
+	}
+	return SearchParams( 0.95, 0.999, 0.02, mode, lbd );
+}
+
+// "mark" holds, per node, the last pair whose cones reached it
+static unsigned
+pairCost( const CirFlatAig& aig, const FraigCand& c, vector<unsigned>& mark,
+          unsigned stamp, vector<unsigned>& stack )
+{
+	unsigned na = aig.node( c._a ), nb = aig.node( c._b );
+	unsigned la = aig.level( na ), lb = aig.level( nb );
+	unsigned size = 0;
+	stack.clear();
+	stack.push_back( na );
+	stack.push_back( nb );
+	while ( !stack.empty() && size < FRAIG_CONE_CAP ) {
+		unsigned n = stack.back();
+		stack.pop_back();
+		if ( mark[n] == stamp ) {
+			continue;
+		}
+		mark[n] = stamp;
+		++size;
+		if ( n >= aig.andBegin() ) {
+			stack.push_back( aig.fanin( n, 0 ) >> 1 );
+			stack.push_back( aig.fanin( n, 1 ) >> 1 );
+		}
+	}
+	return size + FRAIG_DIST_WEIGHT * ( ( la > lb )? la - lb: lb - la );
+}
+
+// Cheapest first; pairs of equal cost keep their order
+static void
+rankPairs( const CirFlatAig& aig, vector<FraigCand>& cands )
+{
+	vector<unsigned> mark( aig.nodeNum(), 0 );
+	vector<unsigned> stack;
+	for ( size_t i = 0; i < cands.size(); ++i ) {
+		cands[i]._cost = pairCost( aig, cands[i], mark, i + 1, stack );
+	}
+	stable_sort( cands.begin(), cands.end() );
+}
+
+/******************************************/
+/*   class FraigProver member functions   */
+/******************************************/
 void
-CirMgr::strash()
+FraigProver::init( unsigned gateNum, const SearchParams& params )
 {
-   Hash<AigashKey, CirGate*> hash( _aigNum / 4 );
-   CirGate* persistG;
-   for ( size_t i = 0; i < _DFSList.size(); ++i ) {
-      if ( _DFSList[i]->getTypeStr() == AigGate::typeName() ) {
-	    AigashKey k( _DFSList[i]->getFanins() );
-	    if ( hash.check( k, persistG ) ) {
-	       cout << "Strashing: " << persistG->getId() 
-		       << " merging " << _DFSList[i]->getId()
-			  << "..." << endl;
-		  mergeStrashGates( persistG, _DFSList[i] );
-	    }
-	    else {
-	       hash.forceInsert( k, _DFSList[i] );
-	    }
-	 }
-   }
-   cleanLists();
-   dfsTraversal();
+	_solver.initialize();
+	_solver.setSearchParams( params );
+	_lits.assign( gateNum, lit_Undef );
+	_lits[0] = Lit( _solver.newVar() );
+	// for good, rather than an assumption of every query
+	_solver.assertProperty( var( _lits[0] ), false );
 }
 
+// Tseitin-encodes the part of the fanin cone of "gid" that is not in the
+// solver yet.  Literals are kept by gate id across fraig rounds: a gate
+// that got a merged fanin stays encoded on the old one, which is
+// equivalent.
+void
+FraigProver::encodeCone( const CirFlatAig& aig, unsigned gid )
+{
+	if ( _lits[gid] != lit_Undef ) {
+		return;
+	}
+	vector<unsigned> stack( 1, aig.node( gid ) );
+	while ( !stack.empty() ) {
+		unsigned n = stack.back();
+		unsigned g = aig.gateId(n);
+		if ( _lits[g] != lit_Undef ) {
+			stack.pop_back();
+			continue;
+		}
+		if ( n < aig.andBegin() ) {
+			_lits[g] = newLit( aig, n );
+			stack.pop_back();
+			continue;
+		}
+		unsigned f0 = aig.fanin( n, 0 );
+		unsigned f1 = aig.fanin( n, 1 );
+		Lit l0 = _lits[ aig.gateId( f0 >> 1 ) ];
+		Lit l1 = _lits[ aig.gateId( f1 >> 1 ) ];
+		if ( l0 == lit_Undef ) {
+			stack.push_back( f0 >> 1 );
+			continue;
+		}
+		if ( l1 == lit_Undef ) {
+			stack.push_back( f1 >> 1 );
+			continue;
+		}
+		_lits[g] = newLit( aig, n );
+		_solver.addAigCNF( var( _lits[g] ), var(l0), sign(l0) ^ ( f0 & 1 ),
+		                   var(l1), sign(l1) ^ ( f1 & 1 ) );
+		stack.pop_back();
+	}
+}
+
+// The variable of node "n", with the hints
+Lit
+FraigProver::newLit( const CirFlatAig& aig, unsigned n )
+{
+	Var v = _solver.newVar();
+	if ( _hints ) {
+		_solver.setPhase( v, _hints->getSimValue( aig.gateId(n) ).bit(0) );
+		_solver.setActivity( v, FRAIG_LEVEL_ACT * aig.level(n) );
+	}
+	return Lit(v);
+}
+
+FraigResult
+FraigProver::prove( const CirFlatAig& aig, unsigned a, unsigned b,
+                    bool isInv )
+{
+	double secs = 0;
+	if ( _deadline > 0 ) {
+		secs = _deadline - realTime();
+		if ( secs <= 0 ) {
+			return FRAIG_UNDEF;
+		}
+	}
+	Var guard = var_Undef;
+	encodeCone( aig, a );
+	encodeCone( aig, b );
+	Lit la = _lits[a], lb = _lits[b];
+	_solver.assumeRelease();
+	if ( a == 0 ) {
+		_solver.assumeProperty( var(lb), !( sign(lb) ^ isInv ) );
+	}
+	else if ( b == 0 ) {
+		_solver.assumeProperty( var(la), !( sign(la) ^ isInv ) );
+	}
+	else {
+		// the miter lives only for this query; retiring its guard also
+		// drops the learnt clauses about it, so the solver does not grow
+		guard = _solver.newGuard();
+		_solver.addGuardedXorCNF( guard, var(la), sign(la),
+		                          var(lb), sign(lb) ^ isInv );
+		_solver.assumeProperty( guard, true );
+	}
+	_solver.setBudget( _conflicts, _props, secs );
+	lbool sat = _solver.assumpSolveLimited();
+	if ( guard != var_Undef ) {
+		_solver.removeGuard( guard );
+	}
+	if ( sat == l_Undef ) {
+		return FRAIG_UNDEF;
+	}
+	return ( sat == l_False )? FRAIG_EQV: FRAIG_NEQ;
+}
+
+// The cones encoded after this use a in place of b, so they stop at a;
+// the clauses b == a let the queries on the cones already in use it too
+void
+FraigProver::merge( unsigned a, unsigned b, bool isInv )
+{
+	Lit la = _lits[a], lb = _lits[b];
+	assert( la != lit_Undef && lb != lit_Undef );
+	_solver.addEqCNF( var(la), sign(la), var(lb), sign(lb) ^ isInv );
+	_lits[b] = isInv? ~la: la;
+}
+
+/****************************************/
+/*   class FraigTask member functions   */
+/****************************************/
+void
+FraigTask::run( unsigned )
+{
+	vector<FraigPair>& pairs = *_pairs;
+	for ( size_t i = _id; i < pairs.size(); i += _num ) {
+		FraigPair& p = pairs[i];
+		p._res = _prover.prove( *_aig, p._a, p._b, p._inv );
+		if ( p._res == FRAIG_EQV ) {
+			_prover.merge( p._a, p._b, p._inv );
+		}
+		if ( p._res != FRAIG_NEQ ) {
+			continue;
+		}
+		p._task = _id;
+		p._cex = _cexs.size();
+		for ( unsigned j = 0; j < _aig->piNum(); ++j ) {
+			_cexs.push_back( _prover.value(
+			                 _aig->gateId( _aig->piNode(j) ) ) );
+		}
+	}
+}
+
+/*******************************************/
+/*   Public member functions about fraig   */
+/*******************************************/
 void
 CirMgr::printFEC() const
 {
@@ -90,100 +363,82 @@ CirMgr::printFEC() const
 void
 CirMgr::fraig()
 {
-	fraigByDFS();
+	_cexBuf.init( _piNum );
+	_unresolved = 0;
+	if ( _pool.size() > 1 ) {
+		fraigParallel();
+	}
+	else {
+		fraigRanked();
+	}
+	if ( _unresolved ) {
+		cout << "Total #unresolved pairs = " << _unresolved << endl;
+	}
 	_simmed = false;
 }
 
+// Every round pairs each gate in a FEC group with the group's lead (see
+// fraigLead()) and proves the pairs cheapest first.  A pair proven
+// equivalent is merged in the prover at once, so the cones encoded after
+// it stop at the lead.  A pair that runs out of its budget is
+// put off until the rest are done and then retried with a larger budget;
+// the counterexamples found meanwhile may separate it for free.  Pairs
+// out of the last budget, or of the time of the whole fraig, are left
+// unresolved.  The gates are merged in the circuit at the end of the
+// round.
 void
-CirMgr::fraigByDFS()
+CirMgr::fraigRanked()
 {
-	SatSolver solver;
-	genProofModel( solver );
-
-	vector<IdList*> eqvGrps;
-
-	unsigned fecGrpId;
-	unsigned curId;
-	unsigned peerId;
-	unsigned leadId;
-	bool isInv;
-	IdList* eqvGrp;
-	//IdList* nonGrp;
-
+	FraigProver prover;
+	prover.init( _AllList.size(),
+	             searchParams( _fraigRestart, _fraigLbd ) );
+	prover.setHints( this );
+
+	vector<FraigCand> cands;
+	vector<FraigCand> deferred;
+	vector<FraigCand> eqvs;
+	double deadline = _fraigTime? realTime() + _fraigTime: 0;
 	while ( !_fecGrps.empty() ) {
-		for ( size_t d = 0; d < _DFSList.size(); ++d ) {
-			curId = _DFSList[d]->getId();
-
-			if ( !_AllList[curId]->checkFec( fecGrpId ) ) {
-				continue;
-			}
-
-			eqvGrp = new IdList;
-			//nonGrp = new IdList; //beta
-			eqvGrps.push_back( eqvGrp );
-			eqvGrp->push_back( curId );
-			//_fecGrps.push_back( nonGrp ); //beta
-			for ( int f = _fecGrps[fecGrpId]->size() - 1; f >= 1; --f ) {
-				peerId = ( *_fecGrps[fecGrpId] )[f];
-				if ( peerId == curId ) {
-					swap( (*_fecGrps[fecGrpId])[f], 
-						  _fecGrps[fecGrpId]->front());
-					++f;
+		fraigCands( cands );
+		for ( unsigned retry = 0; !cands.empty(); ++retry ) {
+			prover.setBudget( retryBudget( _fraigBudget, retry ),
+			                  retryBudget( _fraigProps, retry ), deadline );
+			deferred.clear();
+			for ( size_t i = 0; i < cands.size(); ++i ) {
+				const FraigCand& c = cands[i];
+				// a counterexample may have split the pair already
+				if ( !sameFec( c._a, c._b ) ) {
 					continue;
 				}
-				isInv = ( _AllList[curId]->getSimResult() !=
-				     _AllList[peerId]->getSimResult() );
-				//kickGateFromFec( fecGrpId, f ); //beta
-				if ( checkEqv( solver, curId, peerId, isInv ) ) {
-					kickGateFromFec( fecGrpId, f ); //beta
-					eqvGrp->push_back(peerId);
-					if ( peerId == 0 ) {
-						swap( eqvGrp->back(), eqvGrp->front() );
-					}
-					continue;
+				FraigResult r = checkEqv( prover, c._a, c._b, c._inv );
+				if ( r == FRAIG_EQV ) {
+					prover.merge( c._a, c._b, c._inv );
+					eqvs.push_back( c );
 				}
-
-				//addGateToLastFec( peerId ); //beta
-				if ( packInputs( solver ) ) {
-					if ( justSim() ) {
-						cout << "Updating by SAT... " ;
-						printFEC();
-						cout << endl;
-					}
-					if ( _AllList[curId]->checkFec( fecGrpId ) ) {
-						f = _fecGrps[fecGrpId]->size();
-						continue;
-					}
-					else {
-						break;
-					}
+				else if ( r == FRAIG_UNDEF && retry < FRAIG_RETRIES ) {
+					deferred.push_back( c );
+				}
+				else if ( r == FRAIG_UNDEF ) {
+					leaveUnresolved( c._a, c._b, c._inv );
+				}
+				else if ( packInputs( prover, c._a, c._b ) && flushCexs() ) {
+					cout << "Updating by SAT... " ;
+					printFEC();
+					cout << endl;
 				}
 			}
-			if ( _AllList[curId]->checkFec( fecGrpId ) ) {
-				//killFecGrp( fecGrpId ); //beta
-				kickGateFromFec( fecGrpId, 0 );
-				judgeFecDeath( fecGrpId ); //beta
-			}
-
-			if ( eqvGrps.back()->size() <= 1 ) {
-				delete eqvGrps.back();
-				eqvGrps.pop_back();
-			}
-			//judgeFecDeath( _fecGrps.size() - 1 ); //beta
-
-			if ( eqvGrps.size() > 32 ) {
-				break;
+			if ( flushCexs() ) {
+				cout << "Updating by SAT... " ;
+				printFEC();
+				cout << endl;
 			}
-
+			cands.swap( deferred );
 		}
-		for ( size_t i = 0; i < eqvGrps.size(); ++i ) {
-			leadId = eqvGrps[i]->front();
-			for ( size_t j = 1; j < eqvGrps[i]->size(); ++j ) {
-				mergeEqvGates( leadId, (*eqvGrps[i])[j] );
-			}
-			delete eqvGrps[i];
+
+		for ( size_t i = 0; i < eqvs.size(); ++i ) {
+			mergeEqvGates( eqvs[i]._a, eqvs[i]._b );
 		}
-		eqvGrps.clear();
+		eqvs.clear();
 		cleanDeadFECs();
 		dfsTraversal();
 		sweep();
@@ -191,234 +446,338 @@ CirMgr::fraigByDFS()
 	}
 }
 
+// fraigRanked() on the workers of _pool, each proving with a solver of
+// its own.  The ranked pairs are taken a chunk at a time, skipping the
+// ones the counterexamples have split already; the pairs of a chunk are
+// dealt to the workers in turn (see FraigTask).  After a chunk, its
+// results are taken in pair order: the counterexamples refine the groups
+// before the next chunk is formed, and the pairs out of budget are put
+// off to the next retry.  So neither the pairs a solver proves nor their
+// results depend on the scheduling (but for the time limit of -TIme).
 void
-CirMgr::fraigBFS()
+CirMgr::fraigParallel()
 {
-	SatSolver solver;
-	genProofModel( solver );
-
-	unsigned inputNum;
-	vector<IdList*> eqvGrps;
-
-	const vector< PtrV<CirGate> >* fano;
-	unsigned fecGrpId;
-	unsigned curId;
-	unsigned peerId;
-	unsigned leadId;
-	bool isInv;
-	IdList* eqvGrp;
-	IdList* nonGrp;
+	double deadline = _fraigTime? realTime() + _fraigTime: 0;
+	// a solver can not be copied, so the tasks live on the heap
+	SearchParams params = searchParams( _fraigRestart, _fraigLbd );
+	vector<FraigTask*> tasks( _pool.size() );
+	for ( unsigned w = 0; w < tasks.size(); ++w ) {
+		tasks[w] = new FraigTask( &_flat, w, tasks.size() );
+		tasks[w]->init( _AllList.size(), this, params );
+	}
 
-	deque< unsigned > bfsQ;
+	vector<FraigCand> cands;
+	vector<FraigCand> deferred;
+	vector<FraigCand> eqvs;
+	vector<FraigPair> chunk;
+	size_t chunkSize = FRAIG_CHUNK_PAIRS * tasks.size();
 	while ( !_fecGrps.empty() ) {
-		
-		//init bfsQ
-		CirGate::setGlobalRef();
-		//bfsQ.push_back( _Const0s[0].getId() );
-		//_Const0s[0].setToGlobalRef();
-		for ( size_t i = 0; i < _piNum; ++i ) {
-			bfsQ.push_back( _PIs[i].getId() );
-			_PIs[i].setToGlobalRef();
-		}
-
-		while ( !bfsQ.empty() ) {
-			curId = bfsQ.front();
-			bfsQ.pop_front();
-			fano = &( _AllList[curId]->getFanouts() );
-
-			for ( size_t i = 0; i < fano->size(); ++i ) {
-				if ( !( (*fano)[i].ptr()->isGlobalRef() ) ){
-					(*fano)[i].ptr()->setToGlobalRef();
-					bfsQ.push_back( (*fano)[i].ptr()->getId() );
-				}
-			}
-
-			if ( !_AllList[curId]->checkFec( fecGrpId ) ) {
-				continue;
+		fraigCands( cands );
+		for ( unsigned retry = 0; !cands.empty(); ++retry ) {
+			for ( size_t w = 0; w < tasks.size(); ++w ) {
+				tasks[w]->setBudget( retryBudget( _fraigBudget, retry ),
+				                     retryBudget( _fraigProps, retry ),
+				                     deadline );
 			}
-
-			eqvGrp = new IdList;
-			nonGrp = new IdList;
-			eqvGrps.push_back( eqvGrp );
-			eqvGrp->push_back( curId );
-			_fecGrps.push_back( nonGrp );
-			for ( int i = _fecGrps[fecGrpId]->size() - 1; i >= 1; --i ) {
-				peerId = ( *_fecGrps[fecGrpId] )[i];
-				if ( peerId == curId ) {
-					swap( (*_fecGrps[fecGrpId])[i], 
-						  _fecGrps[fecGrpId]->front());
-					++i;
-					continue;
-				}
-				isInv = ( _AllList[curId]->getSimResult() !=
-				     _AllList[peerId]->getSimResult() );
-				//_fecGrps[fecGrpId]->pop_back();
-				kickGateFromFec( fecGrpId, i );
-				if ( checkEqv( solver, curId, peerId, isInv ) ) {
-					//_AllList[peerId]->clearFec();
-					eqvGrp->push_back(peerId);
-					if ( peerId == 0 ) {
-						swap( eqvGrp->back(), eqvGrp->front() );
+			deferred.clear();
+			for ( size_t i = 0; i < cands.size(); ) {
+				chunk.clear();
+				for ( ; i < cands.size() && chunk.size() < chunkSize; ++i ) {
+					const FraigCand& c = cands[i];
+					if ( sameFec( c._a, c._b ) ) {
+						FraigPair p;
+						p._a = c._a;
+						p._b = c._b;
+						p._inv = c._inv;
+						p._res = FRAIG_UNDEF;
+						p._task = 0;
+						p._cex = 0;
+						chunk.push_back( p );
 					}
-					continue;
 				}
-
-				/*_fecGrps.back()->push_back( peerId );
-				_AllList[peerId]->setFecGrpId( 
-					_fecGrps.size() - 1 )  ;*/
-				addGateToLastFec( peerId );
-				if ( packInputs( solver ) ) {
-					/*if ( _fecGrps.back()->size() <= 1 ) {
-						killFecGrp( _fecGrps.size() - 1 );
-					}*/
-					judgeFecDeath( _fecGrps.size() - 1 );
-					if ( justSim() ) {
-						cout << "Updating by SAT... " ;
-						printFEC();
-						cout << endl;
+				if ( chunk.empty() ) {
+					break;
+				}
+				for ( size_t w = 0; w < tasks.size(); ++w ) {
+					tasks[w]->setPairs( &chunk );
+					_pool.push( tasks[w] );
+				}
+				_pool.wait();
+
+				for ( size_t k = 0; k < chunk.size(); ++k ) {
+					const FraigPair& p = chunk[k];
+					FraigCand c;
+					c._a = p._a;
+					c._b = p._b;
+					c._inv = p._inv;
+					if ( p._res == FRAIG_EQV ) {
+						eqvs.push_back( c );
 					}
-					if ( _AllList[curId]->checkFec( fecGrpId ) ) {
-						i = _fecGrps[fecGrpId]->size();
-						continue;
+					else if ( p._res == FRAIG_UNDEF && retry < FRAIG_RETRIES ) {
+						deferred.push_back( c );
+					}
+					else if ( p._res == FRAIG_UNDEF ) {
+						leaveUnresolved( p._a, p._b, p._inv );
 					}
 					else {
-						break;
+						const char* v = &( tasks[ p._task ]->cexs()[ p._cex ] );
+						vector<char> pis( v, v + _piNum );
+						if ( addCex( pis, p._a, p._b ) && flushCexs() ) {
+							cout << "Updating by SAT... " ;
+							printFEC();
+							cout << endl;
+						}
 					}
 				}
+				if ( flushCexs() ) {
+					cout << "Updating by SAT... " ;
+					printFEC();
+					cout << endl;
+				}
+				for ( size_t w = 0; w < tasks.size(); ++w ) {
+					tasks[w]->clearCexs();
+				}
 			}
-			if ( _AllList[curId]->checkFec( fecGrpId ) ) {
-				/*eraseNoOrder( *_fecGrps[fecGrpId], 0 );
-				_AllList[curId]->clearFec();
-
-				if ( _fecGrps[fecGrpId]->size() <= 1 ) {
-					killFecGrp( fecGrpId );
-				}*/
-				killFecGrp( fecGrpId );
-			}
-
-			if ( eqvGrps.back()->size() <= 1 ) {
-				delete eqvGrps.back();
-				eqvGrps.pop_back();
-			}
-			judgeFecDeath( _fecGrps.size() - 1 );
-			/*if ( _fecGrps.back()->size() <= 1 ) {
-				killFecGrp( _fecGrps.size() - 1 );
-			}*/
-
-			if ( eqvGrps.size() > 32 ) {
-				break;
-			}
-
+			cands.swap( deferred );
 		}
-		for ( size_t i = 0; i < eqvGrps.size(); ++i ) {
-			leadId = eqvGrps[i]->front();
-			for ( size_t j = 1; j < eqvGrps[i]->size(); ++j ) {
-				mergeEqvGates( leadId, (*eqvGrps[i])[j] );
-			}
-			delete eqvGrps[i];
+
+		for ( size_t i = 0; i < eqvs.size(); ++i ) {
+			mergeEqvGates( eqvs[i]._a, eqvs[i]._b );
 		}
-		eqvGrps.clear();
-		bfsQ.clear();
+		eqvs.clear();
 		cleanDeadFECs();
-		//initFECs();
 		dfsTraversal();
 		sweep();
-		justSim();
 	}
-		//cout << countD << endl; //debug
+	for ( size_t w = 0; w < tasks.size(); ++w ) {
+		delete tasks[w];
+	}
 }
 
 /********************************************/
 /*   Private member functions about fraig   */
 /********************************************/
 
-void
-CirMgr::genProofModel( SatSolver& s ) 
+// The member of group g first in the flat AIG: it is in the fanout cone
+// of no other member, so merging them into it can not make a loop
+unsigned
+CirMgr::fraigLead( unsigned g ) const
 {
-	s.initialize();
-
-	int v = s.newVar();
-	_Const0s[0].setVar( v );
-	for ( size_t i = 0; i < _piNum; ++i ) {
-		int v = s.newVar();
-		_PIs[i].setVar( v );
-	}
-	for ( size_t i = 0; i < _DFSList.size(); ++i ) {
-		if ( _DFSList[i]->getTypeStr() == AigGate::typeName() ) {
-			int v = s.newVar();
-			_DFSList[i]->setVar( v );
+	unsigned lead = _fecGrps.id( g, 0 );
+	for ( unsigned j = 1; j < _fecGrps.grpSize(g); ++j ) {
+		if ( _flat.node( _fecGrps.id( g, j ) ) < _flat.node( lead ) ) {
+			lead = _fecGrps.id( g, j );
 		}
 	}
+	return lead;
+}
 
-	for ( size_t i = 0; i < _DFSList.size(); ++i ) {
-		if ( _DFSList[i]->getTypeStr() == 
-			 AigGate::typeName() ) {
-			s.addAigCNF( _DFSList[i]->getVar(), 
-			  (_DFSList[i]->getFanins())[0].ptr()->getVar(), 
-			  (_DFSList[i]->getFanins())[0].isInv(), 
-			  (_DFSList[i]->getFanins())[1].ptr()->getVar(), 
-			  (_DFSList[i]->getFanins())[1].isInv() );
+// The pairs of a round: every gate in a FEC group against the lead of
+// the group, cheapest first
+void
+CirMgr::fraigCands( vector<FraigCand>& cands ) const
+{
+	cands.clear();
+	for ( unsigned g = 0; g < _fecGrps.size(); ++g ) {
+		FraigCand c;
+		c._a = fraigLead( g );
+		for ( unsigned j = 0; j < _fecGrps.grpSize(g); ++j ) {
+			c._b = _fecGrps.id( g, j );
+			if ( c._b != c._a ) {
+				c._inv = isSimInv( c._a, c._b );
+				cands.push_back( c );
+			}
 		}
 	}
+	rankPairs( _flat, cands );
 }
 
+// false once a counterexample has split the pair
 bool
-CirMgr::checkEqv( SatSolver& s, unsigned a, unsigned b, bool isInv ) const
+CirMgr::sameFec( unsigned a, unsigned b ) const
+{
+	unsigned fa, fb;
+	return _AllList[a]->checkFec( fa ) && _AllList[b]->checkFec( fb ) &&
+	       fa == fb;
+}
+
+FraigResult
+CirMgr::checkEqv( FraigProver& p, unsigned a, unsigned b, bool isInv ) const
 {
-	s.assumeRelease();
-	s.assumeProperty( _Const0s[0].getVar(), false );
-	if ( a == 0 ) {
-		s.assumeProperty( _AllList[b]->getVar(), !isInv );
-	}
-	else if ( b == 0 ) {
-		s.assumeProperty( _AllList[a]->getVar(), !isInv );
-	}
-	else {
-		int target = s.newVar();
-		s.addXorCNF( target, _AllList[a]->getVar(), false, 
-							 _AllList[b]->getVar(), isInv );
-		s.assumeProperty( target, true );
-	}
 	cout << "Proving (" << a << ", ";
 	if ( isInv ) {
 		cout << "!" ;
 	}
 	cout << b << ")..." << '\r';
 	cout.flush();
-	return !( s.assumpSolve() );
+	return p.prove( _flat, a, b, isInv );
 }
 
+// Reports a pair no proof could decide and takes "b" out of its FEC
+// group, unmerged; otherwise the pair would come back every round
+void
+CirMgr::leaveUnresolved( unsigned a, unsigned b, bool isInv )
+{
+	cout << "Unresolved (" << a << ", ";
+	if ( isInv ) {
+		cout << "!" ;
+	}
+	cout << b << ")" << endl;
+	++_unresolved;
+
+	unsigned f;
+	if ( !_AllList[b]->checkFec( f ) ) {
+		return;
+	}
+	for ( unsigned j = 0; j < _fecGrps.grpSize(f); ++j ) {
+		if ( _fecGrps.id( f, j ) == b ) {
+			kickGateFromFec( f, j );
+			judgeFecDeath( f );
+			return;
+		}
+	}
+}
+
+// Returns true once the counterexample buffer is full
 bool
-CirMgr::packInputs( const SatSolver& s )
+CirMgr::packInputs( const FraigProver& p, unsigned a, unsigned b )
 {
-	static unsigned bitNum = 0;
-	for ( size_t i = 0; i < _PIs.size(); ++i ) {
-		_PIs[i].setSimBit( bitNum, 
-			s.getValue( _PIs[i].getVar() ) );
+	vector<char> pis( _piNum );
+	for ( size_t i = 0; i < _piNum; ++i ) {
+		pis[i] = p.value( _PIs[i].getId() );
 	}
-	++bitNum;
-	if ( bitNum >= 32 ) {
-		bitNum = 0;
-		return true;
+	return addCex( pis, a, b );
+}
+
+// Buffers the model "pis" that tells "a" from "b".  The values of the PIs
+// out of the fanin cones of the two are made don't cares: the solver may
+// have set them for the earlier pairs, and they do not matter here.
+// Returns true once the buffer is full.
+bool
+CirMgr::addCex( const vector<char>& pis, unsigned a, unsigned b )
+{
+	vector<char> cared( _piNum, -1 );
+	vector<unsigned> stack;
+	stack.push_back( _flat.node(a) );
+	stack.push_back( _flat.node(b) );
+	CirGate::setGlobalRef();
+	while ( !stack.empty() ) {
+		unsigned n = stack.back();
+		stack.pop_back();
+		CirGate* g = _AllList[ _flat.gateId(n) ];
+		if ( g->isGlobalRef() ) {
+			continue;
+		}
+		g->setToGlobalRef();
+		if ( n >= _flat.andBegin() ) {
+			stack.push_back( _flat.fanin( n, 0 ) >> 1 );
+			stack.push_back( _flat.fanin( n, 1 ) >> 1 );
+		}
+		else if ( n >= _flat.piNode(0) && n < _flat.piNode( _piNum ) ) {
+			cared[ n - _flat.piNode(0) ] = pis[ n - _flat.piNode(0) ];
+		}
 	}
-	return false;
+	_cexBuf.add( &cared[0] );
+	return _cexBuf.full();
 }
 
 void
 CirMgr::killFecGrp( unsigned fid )
 {
-	for ( size_t i = 0; i < _fecGrps[fid]->size(); ++i ) {
-		_AllList[ (*_fecGrps[fid])[i] ]->clearFec();
+	for ( unsigned i = 0; i < _fecGrps.grpSize( fid ); ++i ) {
+		_AllList[ _fecGrps.id( fid, i ) ]->clearFec();
 	}
-	delete _fecGrps[fid];
-	eraseNoOrder( _fecGrps, fid );
+	_fecGrps.eraseGrp( fid );
 
 	if ( _fecGrps.empty() || fid >= _fecGrps.size() ) { 
 		return; 
 	}
-	for ( size_t i = 0; i < _fecGrps[fid]->size(); ++i ) {
-		_AllList[ (*_fecGrps[fid])[i] ]->setFecGrpId(fid);
+	for ( unsigned i = 0; i < _fecGrps.grpSize( fid ); ++i ) {
+		_AllList[ _fecGrps.id( fid, i ) ]->setFecGrpId(fid);
+	}
+}
+
+// (Re)builds the unique table from the DFS list, merging every AIG equal
+// to one before it.  readCircuit() hashes the AIGs as it connects them
+// and only needs this for an .aag file with an AIG used before it is
+// defined; the table is kept up to date from then on (see strashGates()).
+void
+CirMgr::strash()
+{
+	unsigned aigNum = _aigNum;
+	_strash.init( _aigNum );
+	GateList work;
+	for ( size_t i = 0; i < _DFSList.size(); ++i ) {
+		work.push_back( _DFSList[i] );
+		strashGates( work );
+	}
+	if ( _aigNum != aigNum ) {
+		cleanLists();
+		dfsTraversal();
+	}
+}
+
+StrashKey
+CirMgr::strashKey( const CirGate* g ) const
+{
+	return StrashKey( ptrV2Lit( g->getFanins()[0] ),
+	                  ptrV2Lit( g->getFanins()[1] ) );
+}
+
+// false for an entry that is stale: its gate is gone or has other fanins
+bool
+CirMgr::isStrashed( unsigned gid, const StrashKey& k ) const
+{
+	return _AllList[gid] && _AllList[gid]->getType() == AIG_GATE &&
+	       strashKey( _AllList[gid] ) == k;
+}
+
+// The gates in "work" are new or have new fanins; each AIG of them is
+// looked up in the unique table.  Of two equal AIGs, the one later in the
+// flat AIG is merged into the other, so that no gate gets a fanin from
+// after it; then the fanouts of the merged one have new fanins in turn.
+// Only the AIGs of _flat are hashed.
+void
+CirMgr::strashGates( GateList& work )
+{
+	while ( !work.empty() ) {
+		CirGate* g = work.back();
+		work.pop_back();
+		unsigned id = g->getId();
+		unsigned n = _flat.node( id );
+		if ( _AllList[id] != g || n < _flat.andBegin() ||
+		     n >= _flat.poBegin() ) {
+			continue;
+		}
+		StrashKey k = strashKey( g );
+		unsigned other;
+		if ( !_strash.check( k, other ) || other == id ||
+		     !isStrashed( other, k ) ) {
+			_strash.replaceInsert( k, id );
+			continue;
+		}
+		CirGate* persist = _AllList[other];
+		if ( _flat.node( other ) > n ) {
+			swap( persist, g );
+			_strash.replaceInsert( k, id );
+		}
+		const vector< PtrV<CirGate> >& fanouts = g->getFanouts();
+		for ( size_t i = 0; i < fanouts.size(); ++i ) {
+			work.push_back( fanouts[i].ptr() );
+		}
+		mergeStrashGates( persist, g );
+	}
+}
+
+// After "g" is replaced: its fanouts have new fanins
+void
+CirMgr::strashFanouts( const CirGate* g )
+{
+	GateList work;
+	for ( size_t i = 0; i < g->getFanouts().size(); ++i ) {
+		work.push_back( g->getFanouts()[i].ptr() );
 	}
+	strashGates( work );
 }
 
 void
@@ -429,15 +788,20 @@ CirMgr::mergeStrashGates( CirGate* persistG, CirGate* dyingG )
 	--_aigNum;
 }
 
+// Either gate may be gone already, by a strash merge after an earlier
+// merge; the next fraig round then takes the pair up again
 void
 CirMgr::mergeEqvGates( unsigned persist, unsigned dying )
 {
-	bool isInv = 
-		( _AllList[persist]->getSimResult() != 
-		  _AllList[dying]->getSimResult() );
-	_AllList[dying]->replaceWithGate( _AllList[persist], isInv );
+	if ( !_AllList[persist] || !_AllList[dying] ) {
+		return;
+	}
+	bool isInv = isSimInv( persist, dying );
+	CirGate* g = _AllList[dying];
+	g->replaceWithGate( _AllList[persist], isInv );
 	_AllList[dying] = 0;
 	--_aigNum;
+	strashFanouts( g );
 }
 
 
@@ -445,7 +809,7 @@ void
 CirMgr::addGateToFec( unsigned f, unsigned g )
 {
 	assert( f < _fecGrps.size() );
-	_fecGrps[f]->push_back( g );
+	_fecGrps.push( f, g );
 	_AllList[ g ]->setFecGrpId( f );
 }
 
@@ -460,9 +824,9 @@ void
 CirMgr::kickGateFromFec( unsigned f, unsigned num )
 {
 	assert( f < _fecGrps.size() );
-	assert( num < _fecGrps[f]->size() );
-	_AllList[ (*_fecGrps[f])[num] ]->clearFec();
-	eraseNoOrder( *_fecGrps[f], num );
+	assert( num < _fecGrps.grpSize(f) );
+	_AllList[ _fecGrps.id( f, num ) ]->clearFec();
+	_fecGrps.erase( f, num );
 }
 
 bool
@@ -474,7 +838,7 @@ CirMgr::judgeFecDeath( unsigned f )
 	if ( f >= _fecGrps.size() || f < 0 ) {
 		return false;
 	}
-	if ( _fecGrps[f]->size() <= 1 ) {
+	if ( _fecGrps.grpSize(f) <= 1 ) {
 		killFecGrp( f );
 		return true;
 	}
@@ -74,8 +74,6 @@ CirGate::printGate() const
 void
 CirGate::reportGate() const
 {
-	unsigned mask;
-	unsigned tempS = _simResult;;
 	//const IdList* grp;
 	ostringstream ss;
 	string temp;
@@ -96,18 +94,19 @@ CirGate::reportGate() const
 
 	ss.str("");
 	ss << "= FECs:" ;
+	const SimWord& simResult = getSimResult();
 	if ( _hasFec ) {
-		const IdList* grp = cirMgr->getFecGrp( _fecId );
-		for ( size_t i = 0; i < grp->size(); ++i ) {
-			if ( (*grp)[i] == _id ) {
+		const CirFecGrps& grps = cirMgr->getFecGrps();
+		for ( unsigned i = 0; i < grps.grpSize( _fecId ); ++i ) {
+			unsigned id = grps.id( _fecId, i );
+			if ( id == _id ) {
 				continue;
 			}
 			ss << " " ;
-			if ( cirMgr->getGate( (*grp)[i] )->getSimResult()
-			  	 == ~_simResult ) {
+			if ( cirMgr->isSimInv( _id, id ) ) {
 				ss << "!" ;
 			}
-			ss << (*grp)[i];
+			ss << id;
 		}
 	}
 	temp = ss.str();
@@ -117,20 +116,21 @@ CirGate::reportGate() const
 	}
 	cout << " =" << endl;
 
-	ss.str("");
-	mask = 1 << ( 8 * sizeof(unsigned) - 1 );
-	ss << "= Value:" << ' ';
-	ss << ( (tempS & mask)? 1 : 0 );
-	for ( size_t i = 1; i < 8 * sizeof(unsigned); ++i ){
-		tempS = tempS << 1;
-		if ( i % 4 == 0 ) {
-			ss << '_';
+	// 32 patterns per row, latest pattern on the left as before
+	const unsigned rowBits = 32;
+	for ( unsigned row = 0; row < SimWord::BITS / rowBits; ++row ) {
+		ss.str("");
+		ss << ( row == 0? "= Value: ": "=        " );
+		for ( unsigned i = 0; i < rowBits; ++i ) {
+			if ( i != 0 && i % 4 == 0 ) {
+				ss << '_';
+			}
+			ss << ( simResult.bit( ( row + 1 ) * rowBits - 1 - i )? 1 : 0 );
 		}
-		ss << ( (tempS & mask)? 1 : 0 );
+		temp = ss.str();
+		cout << temp;
+		cout << right << setw( 50 - temp.size() ) << "=" << endl;
 	}
-	temp = ss.str();
-	cout << temp;
-	cout << right << setw( 50 - temp.size() ) << "=" << endl;
 
 
 	for ( int i = 0; i < 50; ++i ){
@@ -139,6 +139,12 @@ CirGate::reportGate() const
 	cout << endl;
 }
 
+const SimWord&
+CirGate::getSimResult() const
+{
+	return cirMgr->getSimValue( _id );
+}
+
 void
 CirGate::reportFanin(int level) const
 {
@@ -167,6 +173,18 @@ CirGate::addFanout( CirGate* gate, bool isInv, bool isUndef )
 	_fanouts.push_back( PtrV<CirGate>( gate, isInv, isUndef ) );
 }
 
+void
+CirGate::resizeFanouts( unsigned n )
+{
+	_fanouts.resize( n, PtrV<CirGate>( 0 ) );
+}
+
+void
+CirGate::setFanout( unsigned i, CirGate* gate, bool isInv )
+{
+	_fanouts[i] = PtrV<CirGate>( gate, isInv );
+}
+
 void
 CirGate::eraseFanin( CirGate* g )
 {
@@ -341,27 +359,6 @@ Const0Gate::printGate() const
 	cout << _typeStr << 0 ;
 }
 
-void
-POGate::simulate()
-{
-	_simResult = ( _fanins[0].ptr() )->getSimResult();
-	if ( _fanins[0].isInv() ) {
-		_simResult = ~_simResult;
-	}
-}
-
-void
-PIGate::setSimBit( unsigned b, unsigned i )
-{
-	unsigned mask = 1 << b;
-	if ( i == 0 ) {
-		_simResult &= ~mask;
-	}
-	else if ( i == 1 ) {
-		_simResult |= mask;
-	}
-}
-
 bool
 AigGate::selfOptimize( CirGate* the0 )
 {
@@ -386,19 +383,6 @@ AigGate::selfOptimize( CirGate* the0 )
 	return false;
 }
 
-void
-AigGate::simulate()
-{
-	unsigned s[2];
-	for ( size_t i = 0; i < 2; ++i ) {
-		s[i] = ( _fanins[i].ptr() )->getSimResult();
-		if ( _fanins[i].isInv() ) {
-			s[i] = ~s[i];
-		}
-	}
-	_simResult = s[0] & s[1];
-}
-
 void
 UndefGate::dfsPost( vector<CirGate*>& dfsList ) {}
 
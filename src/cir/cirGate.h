@@ -13,6 +13,7 @@
 #include <vector>
 #include <iostream>
 #include "cirDef.h"
+#include "cirSimWord.h"
 
 using namespace std;
 
@@ -27,11 +28,12 @@ class CirGate
 {
 public:
    CirGate( unsigned id, unsigned l, unsigned c = 0, string n = "" ) : 
-      _lineNo(l), _colNo(c), _id(id), _name(n), _ref(0), _simResult(0), _fecId(0), _fecInv(0), _hasFec(0) {}
+      _lineNo(l), _colNo(c), _id(id), _name(n), _ref(0), _fecId(0), _fecInv(0), _hasFec(0) {}
    virtual ~CirGate() {}
 
    // Basic access methods
    virtual string getTypeStr() const = 0;
+   virtual GateType getType() const = 0;
    string getName() const { return _name; }
    void setName( const string& s ) { _name = s; }
    unsigned getLineNo() const { return _lineNo; }
@@ -53,6 +55,8 @@ public:
    //Fanins, fanouts
    void addFanin( CirGate*, bool isInv, bool isUndef = false );
    void addFanout( CirGate*, bool isInv, bool isUndef = false );
+   void resizeFanouts( unsigned n );
+   void setFanout( unsigned i, CirGate*, bool isInv );
    void eraseFanin( CirGate* );
    void eraseFanin(  PtrV<CirGate>);
    void eraseFanout( CirGate* );
@@ -68,17 +72,12 @@ public:
    void replaceWithGate( CirGate*, bool = false );
 
    //simulation
-   virtual void simulate() = 0;
-   unsigned getSimResult() const { return _simResult; }
-   unsigned getSimEqv() const {
-      if ( _fecInv ) {
-	     return ~_simResult;
-	  }
-	  else {
-	     return _simResult;
-	  }
+   const SimWord& getSimResult() const;
+   SimWord getSimEqv() const {
+      return getSimResult() ^ SimWord::mask( _fecInv );
    }
    void setFecInv( bool fI ) { _fecInv = fI; }
+   bool isFecInv() const { return _fecInv; }
    void setFecGrpId( unsigned f ) {
       _fecId = f;
 	  _hasFec = 1;
@@ -92,10 +91,6 @@ public:
 	  return _hasFec;
    }
 
-   //fraig
-   void setVar( int si ) { _satVar = si; }
-   int getVar() const { return _satVar; }
-
 private:
 
 protected:
@@ -119,10 +114,6 @@ protected:
    unsigned _fecInv : 1;
    unsigned _hasFec : 1;
 
-   unsigned _simResult;
-
-   int _satVar;
-
    static unsigned _globalRef;
 
 };
@@ -167,9 +158,9 @@ public:
 	virtual ~Const0Gate() {}
 
 	virtual string getTypeStr() const{ return Const0Gate::_typeStr; }
+	virtual GateType getType() const { return CONST_GATE; }
 
 	virtual void printGate() const;
-	virtual void simulate() {};
 
 	static string typeName() { return _typeStr; }
 private:
@@ -183,14 +174,10 @@ public:
 	virtual ~PIGate() {}
 
 	virtual string getTypeStr() const { return PIGate::_typeStr; }
-
-	virtual void simulate() {};
+	virtual GateType getType() const { return PI_GATE; }
 
 	static string typeName() { return _typeStr; }
 
-	void initSim( unsigned s ) { _simResult = s; }
-	void setSimBit( unsigned b, unsigned i );
-
 	//virtual void dfsPost( vector<CirGate*>& );
 	
 	//virtual void printGate();
@@ -206,11 +193,10 @@ public:
 	virtual ~POGate() {}
 
 	virtual string getTypeStr() const { return POGate::_typeStr; }
+	virtual GateType getType() const { return PO_GATE; }
 
 	virtual void merge( CirGate* g ) {}
 
-	virtual void simulate();
-
 	static string typeName() { return _typeStr; }
 
 	//virtual void dfsPost( vector<CirGate*>& );
@@ -229,11 +215,10 @@ public:
 	virtual ~AigGate() {}
 
 	virtual string getTypeStr() const { return _typeStr; }
+	virtual GateType getType() const { return AIG_GATE; }
 
 	virtual bool selfOptimize( CirGate* the0 );
 
-	virtual void simulate();
-
 	static string typeName() { return _typeStr; }
 
 	//virtual void dfsPost( vector<CirGate*>& );
@@ -251,8 +236,7 @@ public:
 	virtual ~UndefGate() {}
 
 	virtual string getTypeStr() const { return UndefGate::_typeStr; }
-
-	virtual void simulate() {};
+	virtual GateType getType() const { return UNDEF_GATE; }
 
 	static string typeName() { return _typeStr; }
 
@@ -12,10 +12,12 @@
 #include <ctype.h>
 #include <cassert>
 #include <cstring>
+#include <climits>
 #include <algorithm>
 #include "cirMgr.h"
 #include "cirGate.h"
 #include "util.h"
+#include "myMappedFile.h"
 
 using namespace std;
 
@@ -61,7 +63,6 @@ bool gateIdComp( const CirGate* a, const CirGate* b )
 /**************************************/
 static unsigned lineNo = 0;  // in printint, lineNo needs to ++
 static unsigned colNo  = 0;  // in printing, colNo needs to ++
-static char buf[1024];
 static string errMsg;
 static int errInt;
 static CirGate *errGate;
@@ -153,189 +154,302 @@ parseError(CirParseError err)
    return false;
 }
 
-/**************************************************************/
-/*   class CirMgr member functions for circuit construction   */
-/**************************************************************/
-bool
-CirMgr::readCircuit(const string& fileName)
-{
-   ifstream aigFile( fileName.c_str(), ios::in );
+// Scanners over the mapped file.  "cur" never passes "fileEnd"; lineNo
+// and colNo (both 0-based) follow it for parseError().
+static const char* cur = 0;
+static const char* fileEnd = 0;
+static const char* lineBegin = 0;
+static bool binaryAig = false;   // "aig" header: binary AND section
 
-   string tempLine;
-   string identifier;
-   string temp;
-   int rewind;   
-   size_t next = 0;
+static inline bool
+atLineEnd()
+{
+   return ( cur == fileEnd || *cur == '\n' );
+}
 
-   lineNo = 1;
-   colNo = 1;
-   unsigned lineNoRewind = 0;
-   int var[5];
-   int id;
-   int faninId;
-   bool isInv;
-   bool isUndef;
+static bool
+readSpace()
+{
+   colNo = cur - lineBegin;
+   if ( cur == fileEnd || *cur != ' ' ) {
+      return parseError( MISSING_SPACE );
+   }
+   ++cur;
+   return true;
+}
 
-   getline( aigFile, tempLine );
+static bool
+readNewline()
+{
+   colNo = cur - lineBegin;
+   if ( cur == fileEnd ) {
+      return true;
+   }
+   if ( *cur != '\n' ) {
+      return parseError( MISSING_NEWLINE );
+   }
+   lineBegin = ++cur;
    ++lineNo;
-   next = myStrGetTok( tempLine, identifier );
+   return true;
+}
 
-   for ( int i = 0; i < 5; ++i ) {
-      next = myStrGetTok( tempLine, temp, next );
-	 myStr2Int( temp, var[i] );
+// Decodes one 7-bit variable-length delta of a binary AND gate
+static bool
+readDelta( unsigned& d )
+{
+   d = 0;
+   for ( unsigned shift = 0; ; shift += 7 ) {
+      if ( cur == fileEnd ) {
+         errMsg = "AIG";
+         return parseError( MISSING_DEF );
+      }
+      unsigned char c = *cur++;
+      if ( shift > 28 ) {
+         errMsg = "AIG input delta";
+         return parseError( ILLEGAL_NUM );
+      }
+      d |= unsigned( c & 0x7f ) << shift;
+      if ( !( c & 0x80 ) ) {
+         return true;
+      }
    }
+}
 
-   _maxId = var[0];
-   _piNum = var[1];
-   _latNum = var[2];
-   _poNum = var[3];
-   _aigNum = var[4];
-
-   _Const0s.push_back( Const0Gate() );
-   _PIs.reserve( _piNum );
-   _POs.reserve( _poNum );
-   _Aigs.reserve( _aigNum );
-   _Undefs.reserve( _maxId - _aigNum - _piNum );
-   _DFSList.reserve( _piNum + _poNum + _aigNum + _latNum );
-   _AllList.reserve( _maxId + _poNum + 1 );
-   _FloatingList.reserve( _maxId - _aigNum - _piNum );
-
-   _AllList.push_back( &_Const0s[0] );
-   for ( size_t i = 1; i < _AllList.capacity(); ++i ) {
-      _AllList.push_back( 0 );
+static void
+writeDelta( ostream& outfile, unsigned d )
+{
+   while ( d & ~0x7fU ) {
+      outfile.put( char( ( d & 0x7f ) | 0x80 ) );
+      d >>= 7;
    }
+   outfile.put( char( d ) );
+}
 
-   for ( unsigned i = 0; i < _piNum; ++i ) {
-      getline( aigFile, tempLine );
-	 myStrGetTok( tempLine, temp );
-	 myStr2Int( temp, id );
-	 if ( id > 0 ) {
-	    id /= 2;
-	    _PIs.push_back( PIGate( id, lineNo ) );
-	    _AllList[id] = &( _PIs.back() );
-	 }
-	 ++lineNo;
+// Decodes a decimal number straight from the mapped bytes
+static bool
+readNum( unsigned& num, const char* what )
+{
+   colNo = cur - lineBegin;
+   if ( atLineEnd() ) {
+      errMsg = what;
+      return parseError( MISSING_NUM );
    }
-
-   rewind = aigFile.tellg();
-   lineNoRewind = lineNo;
-
-   for ( unsigned i = 0; i < _latNum; ++i ) {
-      getline( aigFile, tempLine );
-	 ++lineNo;
+   if ( *cur == ' ' ) {
+      return parseError( EXTRA_SPACE );
+   }
+   if ( isspace( (unsigned char)*cur ) ) {
+      errInt = *cur;
+      return parseError( ILLEGAL_WSPACE );
+   }
+   const char* b = cur;
+   unsigned long long n = 0;
+   while ( cur != fileEnd && isdigit( (unsigned char)*cur ) && n <= INT_MAX ) {
+      n = n * 10 + ( *cur - '0' );
+      ++cur;
    }
+   if ( n > INT_MAX ||
+        ( cur != fileEnd && !isspace( (unsigned char)*cur ) ) ) {
+      while ( cur != fileEnd && !isspace( (unsigned char)*cur ) ) {
+         ++cur;
+      }
+      errMsg = string( what ) + "(" + string( b, cur ) + ")";
+      return parseError( ILLEGAL_NUM );
+   }
+   num = n;
+   return true;
+}
 
-   for ( unsigned i = 0; i < _poNum; ++i ) {
-      getline( aigFile, tempLine );
-	    id = _maxId + i + 1;
-	    _POs.push_back( POGate( id, lineNo ) );
-	    _AllList[id] = &( _POs.back() );
-	 ++lineNo;
+// Sections with fewer AIGs are parsed by the calling thread alone
+static const unsigned PARSE_GRAIN = 1 << 16;
+
+// Parses a byte range of whole "lhs rhs0 rhs1" lines of an ASCII AND
+// section into its own buffer.  It only accepts well-formed lines and
+// reports nothing: on any doubt the caller rescans serially, which
+// gives the exact parseError() message.
+class AagChunkTask : public ThreadTask
+{
+public:
+   AagChunkTask( const char* b, const char* e )
+      : _begin(b), _end(e), _ok(false) {}
+
+   void run( unsigned ) {
+      const char* p = _begin;
+      _lits.clear();
+      _lits.reserve( 3 * ( ( _end - _begin ) / 8 + 1 ) );
+      while ( p != _end ) {
+         for ( int i = 0; i < 3; ++i ) {
+            unsigned long long n = 0;
+            const char* b = p;
+            while ( p != _end && isdigit( (unsigned char)*p ) &&
+                    n <= INT_MAX ) {
+               n = n * 10 + ( *p++ - '0' );
+            }
+            if ( p == b || n > INT_MAX ) { return; }
+            _lits.push_back( n );
+            char sep = ( i < 2 )? ' ': '\n';
+            if ( p != _end && *p == sep ) { ++p; }
+            else if ( i < 2 || p != _end ) { return; }
+         }
+      }
+      _ok = true;
    }
 
-   for ( unsigned i = 0; i < _aigNum; ++i ) {
-      getline( aigFile, tempLine );
-	 next = myStrGetTok( tempLine, temp );
-	 myStr2Int( temp, id );
+   const IdList& lits() const { return _lits; }
+   bool ok() const { return _ok; }
 
-	 id /= 2;
+private:
+   const char*  _begin;
+   const char*  _end;
+   IdList       _lits;   // 3 literals per AND gate
+   bool         _ok;
+};
 
-	 _Aigs.push_back( AigGate( id, lineNo ) );
-	 _AllList[id] = &( _Aigs.back() );
+// Builds the fanout lists in three passes over the gates with ids in
+// [begin, end):
+//   FANOUT_COUNT  counts the fanouts this task adds to every fanin
+//   FANOUT_OFFSET turns, for the fanin ids in the range, the counts of
+//                 all tasks into their first slot and sizes the lists
+//   FANOUT_FILL   writes the fanouts into the slots
+// Tasks own consecutive ranges, so the lists keep the gate-id order of
+// the serial loop.
+enum FanoutPhase
+{
+   FANOUT_COUNT,
+   FANOUT_OFFSET,
+   FANOUT_FILL
+};
 
-	 ++lineNo;
+class FanoutTask : public ThreadTask
+{
+public:
+   FanoutTask( const GateList& l, vector<FanoutTask>& tasks,
+               unsigned b, unsigned e )
+      : _list(&l), _tasks(&tasks), _begin(b), _end(e),
+        _phase(FANOUT_COUNT) {}
+
+   void setPhase( FanoutPhase p ) { _phase = p; }
+
+   void run( unsigned ) {
+      const GateList& l = *_list;
+      if ( _phase == FANOUT_COUNT ) {
+         _slots.assign( l.size(), 0 );
+         for ( unsigned i = _begin; i < _end; ++i ) {
+            if ( !l[i] ) { continue; }
+            const vector< PtrV<CirGate> >& fanins = l[i]->getFanins();
+            for ( size_t j = 0; j < fanins.size(); ++j ) {
+               ++_slots[fanins[j].ptr()->getId()];
+            }
+         }
+      }
+      else if ( _phase == FANOUT_OFFSET ) {
+         vector<FanoutTask>& tasks = *_tasks;
+         for ( unsigned id = _begin; id < _end; ++id ) {
+            unsigned n = 0;
+            for ( size_t t = 0; t < tasks.size(); ++t ) {
+               unsigned c = tasks[t]._slots[id];
+               tasks[t]._slots[id] = n;
+               n += c;
+            }
+            if ( l[id] && n ) { l[id]->resizeFanouts( n ); }
+         }
+      }
+      else {
+         for ( unsigned i = _begin; i < _end; ++i ) {
+            if ( !l[i] ) { continue; }
+            const vector< PtrV<CirGate> >& fanins = l[i]->getFanins();
+            for ( size_t j = 0; j < fanins.size(); ++j ) {
+               CirGate* f = fanins[j].ptr();
+               f->setFanout( _slots[f->getId()]++, l[i], fanins[j].isInv() );
+            }
+         }
+      }
    }
 
-   aigFile.seekg( rewind );
-   lineNo = lineNoRewind;
+private:
+   const GateList*      _list;
+   vector<FanoutTask>*  _tasks;
+   unsigned             _begin;
+   unsigned             _end;
+   FanoutPhase          _phase;
+   IdList               _slots;   // per fanin id: count, then next slot
+};
 
-   for ( unsigned i = 0; i < _poNum; ++i ) {
-      getline( aigFile, tempLine );
-	 myStrGetTok( tempLine, temp );
-	 myStr2Int( temp, faninId );
-	 if ( faninId >= 0 ) {
-	    isInv = ( faninId % 2 != 0 );
-	    faninId /= 2;
-	    if ( !( _AllList[faninId] ) ) {
-		  _Undefs.push_back( UndefGate( faninId ) );
-		  _AllList[faninId] = &(_Undefs.back());
-	    }
-	    isUndef = !( _AllList[faninId] ) || 
-	       ( _AllList[faninId]->getTypeStr() == 
-		    UndefGate::typeName() ) ;
-	    if ( isUndef ) {
-	       _FloatingList.push_back( _POs[i].getId() );
-	    }
-	    _POs[i].addFanin( _AllList[faninId], isInv, isUndef );
-	 }
-	 ++lineNo;
+/**************************************************************/
+/*   class CirMgr member functions for circuit construction   */
+/**************************************************************/
+// Single pass over the mmap'ed file: gates are created as their lines
+// are scanned, the fanin literals are kept aside, and the fanins are
+// connected once every gate exists.
+bool
+CirMgr::readCircuit(const string& fileName)
+{
+   MappedFile aigFile;
+   if ( !aigFile.open( fileName ) ) {
+      cerr << "Cannot open design \"" << fileName << "\"!!" << endl;
+      return false;
+   }
+   cur = lineBegin = aigFile.begin();
+   fileEnd = aigFile.end();
+   lineNo = colNo = 0;
+
+   IdList poLits;
+   IdList aigLits;
+   if ( !readHeader() || !readInputs() || !readOutputs( poLits ) ||
+        !readAigs( aigLits ) || !readSymbols() ) {
+      return false;
    }
+   aigFile.close();
 
+   // Each AIG is looked up in the unique table as it is connected, and a
+   // duplicate is dropped before anything uses it: "rep" maps its id to
+   // the AIG it equals.  This needs the fanins of an AIG connected before
+   // it, as in every .aig file; from the first AIG of an .aag file that
+   // uses a later one, the rest is left to strash() after the DFS.
+   _strash.init( _aigNum );
+   IdList rep( _maxId + 1 );
+   for ( unsigned i = 0; i <= _maxId; ++i ) {
+      rep[i] = i;
+   }
+   bool ordered = true;
    bool floatRecorded;
-   for ( unsigned i = 0; i < _aigNum; ++i ) {
-      getline( aigFile, tempLine );
-	 next = myStrGetTok( tempLine, temp );
-	 floatRecorded = false;
-
-	 for ( unsigned j = 0; j < 2; ++j ) {
-	    next = myStrGetTok( tempLine, temp, next );
-	    myStr2Int( temp, faninId );
-	    isInv = ( faninId % 2 != 0 );
-	    faninId /= 2;
-	    if ( !_AllList[faninId] ) {
-		  _Undefs.push_back( UndefGate( faninId ) );
-		  _AllList[faninId] = &(_Undefs.back());
-	    }
-	    isUndef = !_AllList[faninId] || 
-	       ( _AllList[faninId]->getTypeStr() == 
-		    UndefGate::typeName() );
-	    if ( isUndef && !floatRecorded ) {
-	       _FloatingList.push_back( _Aigs[i].getId() );
-		  floatRecorded = true;
-	    }
-	    _Aigs[i].addFanin( _AllList[faninId], isInv, isUndef );
-	 }
-	 ++lineNo;
+   unsigned lits[2];
+   for ( size_t i = 0; i < _Aigs.size(); ++i ) {
+      for ( unsigned j = 0; j < 2; ++j ) {
+         unsigned lit = aigLits[2 * i + j];
+         lits[j] = 2 * rep[lit / 2] + lit % 2;
+         const CirGate* f = _AllList[lits[j] / 2];
+         if ( f && f->getType() == AIG_GATE && f->getFanins().empty() ) {
+            ordered = false;
+         }
+      }
+      unsigned id = _Aigs[i].getId();
+      if ( ordered ) {
+         StrashKey k( lits[0], lits[1] );
+         if ( _strash.check( k, rep[id] ) ) {
+            _AllList[id] = 0;
+            --_aigNum;
+            continue;
+         }
+         _strash.forceInsert( k, id );
+      }
+      floatRecorded = false;
+      for ( unsigned j = 0; j < 2; ++j ) {
+         if ( connectFanin( _Aigs[i], lits[j] ) && !floatRecorded ) {
+            _FloatingList.push_back( id );
+            floatRecorded = true;
+         }
+      }
    }
-
-   string specifier;
-   string symbol;
-   while ( getline( aigFile, tempLine ) ) {
-	 next = tempLine.find_first_not_of( ' ' );
-	 specifier = tempLine.substr(next, 1);
-	 if ( specifier == "c" ) {
-	    break;
-	 }
-
-	 next = myStrGetTok( tempLine, temp, next + 1 );
-	 next = tempLine.find_first_not_of( ' ', next );
-	 symbol = tempLine.substr( next );
-	 myStr2Int( temp, id );
-	 if ( specifier == "i" ) {
-	    if ( id < _PIs.size() ) {
-	       _PIs[id].setName( symbol );
-	    }
-	 }
-	 else if ( specifier == "o" ) {
-	    if ( id < _POs.size() ) {
-	       _POs[id].setName( symbol );
-	    }
-	 }
+   for ( unsigned i = 0; i < _poNum; ++i ) {
+      unsigned lit = 2 * rep[poLits[i] / 2] + poLits[i] % 2;
+      if ( connectFanin( _POs[i], lit ) ) {
+         _FloatingList.push_back( _POs[i].getId() );
+      }
    }
 
-   aigFile.close();
-
    //end parsing 
 
-   for ( size_t i = 0; i < _AllList.size(); ++i ) {
-      if ( _AllList[i] ) {
-	    const vector< PtrV<CirGate> >& fanins = _AllList[i]->getFanins();
-	    for ( size_t j = 0; j < fanins.size(); ++j ) {
-	       ( fanins[j].ptr() )->addFanout( 
-		     _AllList[i], fanins[j].isInv() );
-	    }
-	 }
-   }
+   buildFanouts();
 
    sort( _FloatingList.begin(), _FloatingList.end() );
 
@@ -346,7 +460,8 @@ CirMgr::readCircuit(const string& fileName)
    }
 
    for ( size_t i = 0; i < _Aigs.size(); ++i ) {
-      if ( ( _Aigs[i].getFanouts() ).empty() ) {
+      if ( _AllList[ _Aigs[i].getId() ] == &_Aigs[i] &&
+           ( _Aigs[i].getFanouts() ).empty() ) {
 	    _UnusedList.push_back( _Aigs[i].getId() );
 	 }
    }
@@ -355,12 +470,401 @@ CirMgr::readCircuit(const string& fileName)
 
 
    dfsTraversal();
+   if ( !ordered ) {
+      strash();
+   }
 
    //initFECs();
 
    return true;
 }
 
+// Returns true if the fanin is undefined
+bool
+CirMgr::connectFanin( CirGate& g, unsigned lit )
+{
+   unsigned faninId = lit / 2;
+   if ( !_AllList[faninId] ) {
+      _Undefs.push_back( UndefGate( faninId ) );
+      _AllList[faninId] = &( _Undefs.back() );
+   }
+   bool isUndef = ( _AllList[faninId]->getType() == UNDEF_GATE );
+   g.addFanin( _AllList[faninId], lit % 2 != 0, isUndef );
+   return isUndef;
+}
+
+bool
+CirMgr::readHeader()
+{
+   static const char* numName[5] = { "number of variables",
+      "number of PIs", "number of latches", "number of POs",
+      "number of AIGs" };
+
+   const char* b = cur;
+   while ( cur != fileEnd && !isspace( (unsigned char)*cur ) ) {
+      ++cur;
+   }
+   if ( cur == b ) {
+      if ( cur != fileEnd && *cur == ' ' ) {
+         return parseError( EXTRA_SPACE );
+      }
+      errMsg = "aag";
+      return parseError( MISSING_IDENTIFIER );
+   }
+   binaryAig = ( string( b, cur ) == "aig" );
+   if ( !binaryAig && string( b, cur ) != "aag" ) {
+      errMsg = string( b, cur );
+      return parseError( ILLEGAL_IDENTIFIER );
+   }
+
+   unsigned var[5];
+   for ( int i = 0; i < 5; ++i ) {
+      colNo = cur - lineBegin;
+      if ( atLineEnd() ) {
+         errMsg = numName[i];
+         return parseError( MISSING_NUM );
+      }
+      if ( !readSpace() || !readNum( var[i], numName[i] ) ) {
+         return false;
+      }
+   }
+
+   _maxId = var[0];
+   _piNum = var[1];
+   _latNum = var[2];
+   _poNum = var[3];
+   _aigNum = var[4];
+   if ( _maxId < _piNum + _latNum + _aigNum ) {
+      errMsg = "Num of variables";
+      errInt = _maxId;
+      return parseError( NUM_TOO_SMALL );
+   }
+   // binary AIGER numbers the variables implicitly
+   if ( binaryAig && _maxId > _piNum + _latNum + _aigNum ) {
+      errMsg = "Num of variables";
+      errInt = _maxId;
+      return parseError( NUM_TOO_BIG );
+   }
+   if ( !readNewline() ) {
+      return false;
+   }
+
+   _Const0s.push_back( Const0Gate() );
+   _PIs.reserve( _piNum );
+   _POs.reserve( _poNum );
+   _Aigs.reserve( _aigNum );
+   _Undefs.reserve( _maxId - _aigNum - _piNum );
+   _DFSList.reserve( _piNum + _poNum + _aigNum + _latNum );
+   _AllList.assign( _maxId + _poNum + 1, 0 );
+   _AllList[0] = &_Const0s[0];
+   _FloatingList.reserve( _maxId - _aigNum - _piNum );
+   return true;
+}
+
+// Checks a literal defining a PI or an AIG gate
+bool
+CirMgr::checkDefLit( unsigned lit, const char* type ) const
+{
+   errInt = lit;
+   if ( lit / 2 == 0 ) {
+      return parseError( REDEF_CONST );
+   }
+   if ( lit % 2 != 0 ) {
+      errMsg = type;
+      return parseError( CANNOT_INVERTED );
+   }
+   if ( lit / 2 > _maxId ) {
+      return parseError( MAX_LIT_ID );
+   }
+   if ( _AllList[lit / 2] ) {
+      errGate = _AllList[lit / 2];
+      return parseError( REDEF_GATE );
+   }
+   return true;
+}
+
+bool
+CirMgr::readInputs()
+{
+   unsigned lit;
+   for ( unsigned i = 0; binaryAig && i < _piNum; ++i ) {
+      _PIs.push_back( PIGate( i + 1, lineNo ) );
+      _AllList[i + 1] = &( _PIs.back() );
+   }
+   for ( unsigned i = 0; !binaryAig && i < _piNum; ++i ) {
+      if ( cur == fileEnd ) {
+         errMsg = "PI";
+         return parseError( MISSING_DEF );
+      }
+      if ( !readNum( lit, "PI literal ID" ) || !checkDefLit( lit, "PI" ) ) {
+         return false;
+      }
+      _PIs.push_back( PIGate( lit / 2, lineNo + 1 ) );
+      _AllList[lit / 2] = &( _PIs.back() );
+      if ( !readNewline() ) {
+         return false;
+      }
+   }
+   // latches are not supported; their lines are skipped
+   for ( unsigned i = 0; i < _latNum; ++i ) {
+      if ( cur == fileEnd ) {
+         errMsg = "latch";
+         return parseError( MISSING_DEF );
+      }
+      while ( !atLineEnd() ) {
+         ++cur;
+      }
+      readNewline();
+   }
+   return true;
+}
+
+bool
+CirMgr::readOutputs( IdList& lits )
+{
+   unsigned lit;
+   lits.resize( _poNum );
+   for ( unsigned i = 0; i < _poNum; ++i ) {
+      if ( cur == fileEnd ) {
+         errMsg = "PO";
+         return parseError( MISSING_DEF );
+      }
+      if ( !readNum( lit, "PO literal ID" ) ) {
+         return false;
+      }
+      if ( lit / 2 > _maxId ) {
+         errInt = lit;
+         return parseError( MAX_LIT_ID );
+      }
+      lits[i] = lit;
+      _POs.push_back( POGate( _maxId + i + 1, lineNo + 1 ) );
+      _AllList[_maxId + i + 1] = &( _POs.back() );
+      if ( !readNewline() ) {
+         return false;
+      }
+   }
+   return true;
+}
+
+bool
+CirMgr::readAigs( IdList& lits )
+{
+   unsigned lit;
+   lits.resize( 2 * _aigNum );
+   if ( binaryAig ) {
+      return readBinaryAigs( lits );
+   }
+   if ( _pool.size() > 1 && _aigNum >= PARSE_GRAIN ) {
+      const char* b = cur;
+      unsigned line = lineNo;
+      if ( readAigsParallel( lits ) ) {
+         return true;
+      }
+      // drop what was merged and rescan to report the error
+      for ( size_t i = 0; i < _Aigs.size(); ++i ) {
+         _AllList[ _Aigs[i].getId() ] = 0;
+      }
+      _Aigs.clear();
+      cur = lineBegin = b;
+      lineNo = line;
+   }
+   for ( unsigned i = 0; i < _aigNum; ++i ) {
+      if ( cur == fileEnd ) {
+         errMsg = "AIG";
+         return parseError( MISSING_DEF );
+      }
+      if ( !readNum( lit, "AIG gate literal ID" ) ||
+           !checkDefLit( lit, "AIG gate" ) ) {
+         return false;
+      }
+      _Aigs.push_back( AigGate( lit / 2, lineNo + 1 ) );
+      _AllList[lit / 2] = &( _Aigs.back() );
+      for ( unsigned j = 0; j < 2; ++j ) {
+         if ( !readSpace() || !readNum( lit, "AIG input literal ID" ) ) {
+            return false;
+         }
+         if ( lit / 2 > _maxId ) {
+            errInt = lit;
+            return parseError( MAX_LIT_ID );
+         }
+         lits[2 * i + j] = lit;
+      }
+      if ( !readNewline() ) {
+         return false;
+      }
+   }
+   return true;
+}
+
+// Splits the AND section at newlines into one byte range per thread,
+// parses the ranges concurrently and merges them in file order.
+// Returns false, without reporting, if anything is wrong.
+bool
+CirMgr::readAigsParallel( IdList& lits )
+{
+   const char* b = cur;
+   const char* e = cur;
+   for ( unsigned i = 0; i < _aigNum; ++i ) {
+      e = (const char*)memchr( e, '\n', fileEnd - e );
+      if ( !e ) {
+         if ( i + 1 < _aigNum ) { return false; }
+         e = fileEnd;
+         break;
+      }
+      ++e;
+   }
+
+   vector<AagChunkTask> tasks;
+   unsigned taskNum = _pool.size();
+   tasks.reserve( taskNum );
+   for ( unsigned t = 0; t < taskNum && b != e; ++t ) {
+      const char* m = b + ( e - b ) / ( taskNum - t );
+      if ( m != e ) {
+         m = (const char*)memchr( m, '\n', e - m );
+         m = m? m + 1: e;
+      }
+      tasks.push_back( AagChunkTask( b, m ) );
+      b = m;
+   }
+   for ( size_t t = 0; t < tasks.size(); ++t ) {
+      _pool.push( &tasks[t] );
+   }
+   _pool.wait();
+
+   unsigned k = 0;
+   for ( size_t t = 0; t < tasks.size(); ++t ) {
+      if ( !tasks[t].ok() ) {
+         return false;
+      }
+      const IdList& l = tasks[t].lits();
+      for ( size_t i = 0; i < l.size(); i += 3, ++k ) {
+         unsigned id = l[i] / 2;
+         if ( id == 0 || l[i] % 2 != 0 || id > _maxId || _AllList[id] ||
+              l[i + 1] / 2 > _maxId || l[i + 2] / 2 > _maxId ) {
+            return false;
+         }
+         _Aigs.push_back( AigGate( id, lineNo + k + 1 ) );
+         _AllList[id] = &( _Aigs.back() );
+         lits[2 * k] = l[i + 1];
+         lits[2 * k + 1] = l[i + 2];
+      }
+   }
+   if ( k != _aigNum ) {
+      return false;
+   }
+   cur = lineBegin = e;
+   lineNo += _aigNum;
+   return true;
+}
+
+// AND gate i is literal 2 * (I + L + i + 1); its fanins are stored as
+// the deltas lhs - rhs0 and rhs0 - rhs1 (lhs > rhs0 >= rhs1)
+bool
+CirMgr::readBinaryAigs( IdList& lits )
+{
+   unsigned lhs, d0, d1;
+   for ( unsigned i = 0; i < _aigNum; ++i ) {
+      lhs = 2 * ( _piNum + _latNum + i + 1 );
+      if ( !readDelta( d0 ) || !readDelta( d1 ) ) {
+         return false;
+      }
+      if ( d0 == 0 || d0 > lhs || d1 > lhs - d0 ) {
+         errMsg = "AIG input delta";
+         return parseError( ILLEGAL_NUM );
+      }
+      _Aigs.push_back( AigGate( lhs / 2, lineNo + 1 ) );
+      _AllList[lhs / 2] = &( _Aigs.back() );
+      lits[2 * i] = lhs - d0;
+      lits[2 * i + 1] = lhs - d0 - d1;
+   }
+   lineBegin = cur;
+   return true;
+}
+
+bool
+CirMgr::readSymbols()
+{
+   unsigned idx;
+   while ( cur != fileEnd ) {
+      colNo = 0;
+      char type = *cur;
+      if ( type == 'c' ) {
+         ++cur;
+         return readNewline();
+      }
+      if ( type != 'i' && type != 'o' ) {
+         errMsg = isprint( (unsigned char)type )? string( 1, type ): "";
+         return parseError( ILLEGAL_SYMBOL_TYPE );
+      }
+      ++cur;
+      if ( !readNum( idx, "symbol index" ) ) {
+         return false;
+      }
+      CirGate* g = 0;
+      if ( type == 'i' && idx < _PIs.size() ) { g = &_PIs[idx]; }
+      if ( type == 'o' && idx < _POs.size() ) { g = &_POs[idx]; }
+      if ( !g ) {
+         errMsg = ( type == 'i' )? "PI index": "PO index";
+         errInt = idx;
+         return parseError( NUM_TOO_BIG );
+      }
+      if ( atLineEnd() ) {
+         errMsg = "symbolic name";
+         return parseError( MISSING_IDENTIFIER );
+      }
+      if ( !readSpace() ) {
+         return false;
+      }
+      const char* b = cur;
+      for ( ; !atLineEnd(); ++cur ) {
+         if ( !isprint( (unsigned char)*cur ) ) {
+            colNo = cur - lineBegin;
+            errInt = *cur;
+            return parseError( ILLEGAL_SYMBOL_NAME );
+         }
+      }
+      if ( cur == b ) {
+         errMsg = "symbolic name";
+         return parseError( MISSING_IDENTIFIER );
+      }
+      if ( !g->getName().empty() ) {
+         errMsg = string( 1, type );
+         errInt = idx;
+         return parseError( REDEF_SYMBOLIC_NAME );
+      }
+      g->setName( string( b, cur ) );
+      if ( !readNewline() ) {
+         return false;
+      }
+   }
+   return true;
+}
+
+// Each task takes a range of gates; see FanoutTask for the passes
+void
+CirMgr::buildFanouts()
+{
+   unsigned taskNum = _pool.size();
+   if ( _AllList.size() < PARSE_GRAIN ) {
+      taskNum = 1;
+   }
+   vector<FanoutTask> tasks;
+   tasks.reserve( taskNum );
+   unsigned step = _AllList.size() / taskNum + 1;
+   for ( unsigned b = 0; b < _AllList.size(); b += step ) {
+      unsigned e = min( b + step, unsigned( _AllList.size() ) );
+      tasks.push_back( FanoutTask( _AllList, tasks, b, e ) );
+   }
+   FanoutPhase phases[] = { FANOUT_COUNT, FANOUT_OFFSET, FANOUT_FILL };
+   for ( unsigned p = 0; p < 3; ++p ) {
+      for ( size_t t = 0; t < tasks.size(); ++t ) {
+         tasks[t].setPhase( phases[p] );
+         _pool.push( &tasks[t] );
+      }
+      _pool.wait();
+   }
+}
+
 /**********************************************************/
 /*   class CirMgr member functions for circuit printing   */
 /**********************************************************/
@@ -446,14 +950,14 @@ CirMgr::printFECPairs() const
 		return;
 	}
 	unsigned id;
-	unsigned leadSim;
-	for ( size_t i = 0; i < _fecGrps.size(); ++i ) {
+	unsigned leadId;
+	for ( unsigned i = 0; i < _fecGrps.size(); ++i ) {
 		cout << "[" << i << "]" ;
-		leadSim = _AllList[ ( *_fecGrps[i] )[0] ]->getSimResult();
-		for ( size_t j = 0; j < _fecGrps[i]->size(); ++j ){
+		leadId = _fecGrps.id( i, 0 );
+		for ( unsigned j = 0; j < _fecGrps.grpSize(i); ++j ){
 			cout << " " ;
-			id = ( *_fecGrps[i] )[j];
-			if ( _AllList[ id ]->getSimResult() == ~leadSim ){
+			id = _fecGrps.id( i, j );
+			if ( isSimInv( leadId, id ) ){
 				cout << "!" ;
 			}
 			cout << id;
@@ -504,6 +1008,63 @@ CirMgr::writeAag(ostream& outfile) const
 	outfile << "AAG output by Chung-Yang (Ric) Huang" << endl;
 }
 
+// Binary AIGER needs the variables numbered PIs first, then the AIGs in
+// topological order; UNDEF fanins are written as constant 0.
+void
+CirMgr::writeAig(ostream& outfile) const
+{
+	vector<unsigned> var( _AllList.size(), 0 );
+	unsigned v = 0;
+	for ( size_t i = 0; i < _PIs.size(); ++i ) {
+		var[ _PIs[i].getId() ] = ++v;
+	}
+	for ( size_t i = 0; i < _DFSList.size(); ++i ) {
+		if ( _DFSList[i]->getType() == AIG_GATE ) {
+			var[ _DFSList[i]->getId() ] = ++v;
+		}
+	}
+
+	outfile << "aig" << " " << v << " " << _piNum 
+	     << " 0 " << _poNum << " " << _aigInDfsNum << endl;
+	for ( size_t i = 0; i < _POs.size(); ++i ) {
+		const PtrV<CirGate>& f = (_POs[i].getFanins())[0];
+		outfile << 2 * var[ f.ptr()->getId() ] + f.isInv() << endl;
+	}
+
+	unsigned lhs, lit[2];
+	for ( size_t i = 0; i < _DFSList.size(); ++i ) {
+		if ( _DFSList[i]->getType() != AIG_GATE ) {
+			continue;
+		}
+		lhs = 2 * var[ _DFSList[i]->getId() ];
+		for ( size_t j = 0; j < 2; ++j ) {
+			const PtrV<CirGate>& f = (_DFSList[i]->getFanins())[j];
+			lit[j] = 2 * var[ f.ptr()->getId() ] + f.isInv();
+		}
+		if ( lit[0] < lit[1] ) {
+			swap( lit[0], lit[1] );
+		}
+		writeDelta( outfile, lhs - lit[0] );
+		writeDelta( outfile, lit[0] - lit[1] );
+	}
+
+	for ( size_t i = 0; i < _PIs.size(); ++i ) {
+		if ( !(_PIs[i].getName()).empty() ) {
+			outfile << "i" << i << " " 
+				<< _PIs[i].getName() << endl;
+		}
+	}
+	for ( size_t i = 0; i < _POs.size(); ++i ) {
+		if ( !(_POs[i].getName()).empty() ){
+			outfile << "o" << i << " "
+				<< _POs[i].getName() << endl;
+		}
+	}
+
+	outfile << "c" << endl;
+	outfile << "AIG output by Chung-Yang (Ric) Huang" << endl;
+}
+
 void
 CirMgr::dfsTraversal()
 {
@@ -513,12 +1074,27 @@ CirMgr::dfsTraversal()
 		_POs[i].dfsPost( _DFSList );
 	}
 
-	_aigInDfsNum = 0;
-	for ( size_t i = 0; i < _DFSList.size(); ++i ) {
-		if ( _DFSList[i]->getTypeStr() == AigGate::typeName() ) {
-		   ++_aigInDfsNum;
+	// rebuild the flat AIG; carry the simulation values over by gate id
+	CirFlatAig flat;
+	flat.build( _DFSList, _PIs, _POs, _AllList.size() );
+	// a gate new to the list has no value, so the next simulation must be
+	// a full one
+	vector<SimWord> values( _simWords * flat.nodeNum() );
+	for ( unsigned n = 0; n < flat.nodeNum(); ++n ) {
+		unsigned o = _flat.node( flat.gateId(n) );
+		if ( o >= _flat.nodeNum() ) {
+			_simSynced = false;
+			continue;
+		}
+		for ( unsigned k = 0; k < _simWords; ++k ) {
+			values[ k * flat.nodeNum() + n ] = 
+				_simValues[ k * _flat.nodeNum() + o ];
 		}
 	}
+	_flat.swap( flat );
+	_simValues.swap( values );
+
+	_aigInDfsNum = _flat.andNum();
 }
 
 void
@@ -539,22 +1115,21 @@ CirMgr::gateFuneral( unsigned dead )
 void
 CirMgr::cleanDeadFECs()
 {
-	for ( int i = 0; i < _fecGrps.size(); ++i ) {
-		for ( int j = 0; j < _fecGrps[i]->size(); ++j ) {
-			if ( _AllList[ (*_fecGrps[i])[j] ] == 0) {
-				eraseNoOrder( *_fecGrps[i], j );
+	for ( int i = 0; i < (int)_fecGrps.size(); ++i ) {
+		for ( int j = 0; j < (int)_fecGrps.grpSize(i); ++j ) {
+			if ( _AllList[ _fecGrps.id( i, j ) ] == 0) {
+				_fecGrps.erase( i, j );
 				--j;
 			}
 			else {
-				_AllList[ (*_fecGrps[i])[j] ]->setFecGrpId(i);
+				_AllList[ _fecGrps.id( i, j ) ]->setFecGrpId(i);
 			}
 		}
-		if ( _fecGrps[i]->size() <= 1 ) {
-			for ( size_t j = 0; j < _fecGrps[i]->size(); ++j ){
-				_AllList[ (*_fecGrps[i])[j] ]->clearFec();
+		if ( _fecGrps.grpSize(i) <= 1 ) {
+			for ( unsigned j = 0; j < _fecGrps.grpSize(i); ++j ){
+				_AllList[ _fecGrps.id( i, j ) ]->clearFec();
 			}
-			delete _fecGrps[i];
-			eraseNoOrder( _fecGrps, i );
+			_fecGrps.eraseGrp( i );
 			--i;
 		}
 	}
@@ -564,7 +1139,7 @@ void
 CirMgr::cleanDeadFloating() const
 {
 	for ( int i = 0; i < _FloatingList.size(); ++i ) {
-		if ( !_AllList[i] ) {
+		if ( !_AllList[ _FloatingList[i] ] ) {
 			eraseNoOrder( _FloatingList, i );
 			--i;
 		}
@@ -17,6 +17,12 @@
 using namespace std;
 
 #include "cirDef.h"
+#include "cirSimWord.h"
+#include "cirFlatAig.h"
+#include "cirCexBuf.h"
+#include "cirFecGrps.h"
+#include "cirStrash.h"
+#include "myHash.h"
 
 extern CirMgr *cirMgr;
 
@@ -24,7 +30,13 @@ extern CirMgr *cirMgr;
 class CirMgr
 {
 public:
-   CirMgr() : _simmed( false ) {}
+   CirMgr() : _simWords( 1 ), _simWordsUsed( 0 ),
+              _simWordsSet( SIM_ROUND_WORDS ), _simSynced( false ),
+              _fecEngine( FEC_SORT ),
+              _fraigBudget( 0 ), _fraigProps( 0 ), _fraigTime( 0 ),
+              _fraigRestart( FRAIG_GEOMETRIC ), _fraigLbd( false ),
+              _unresolved( 0 ), _simmed( false ), _simLog( 0 ),
+              _simPack( 0 ) {}
    ~CirMgr() {}
 
    // Access functions
@@ -33,6 +45,14 @@ public:
       if ( gid < _AllList.size() ) { return _AllList[gid]; }
 	 else { return 0; }
    }
+   unsigned getNumPIs() const { return _piNum; }
+   unsigned getNumPOs() const { return _poNum; }
+
+   // Worker threads for parsing and simulation; 1 runs serially
+   void setThreads( unsigned n ) {
+      if ( n != _pool.size() ) { _pool.start( n ); }
+   }
+   unsigned getThreads() const { return _pool.size(); }
 
    // Member functions about circuit construction
    bool readCircuit(const string&);
@@ -43,17 +63,46 @@ public:
 
    // Member functions about simulation
    void randomSim();
-   void fileSim(ifstream&);
-   void setSimLog(ofstream *logFile) { _simLog = logFile; }
-   const IdList* getFecGrp( unsigned i ) const {
-      return _fecGrps[i];
+   void fileSim( CirPatternReader& );
+   void setSimLog( CirPatternWriter* logFile ) { _simLog = logFile; }
+   // also saves the simulated patterns, packed
+   void setSimPack( CirPatternWriter* w ) { _simPack = w; }
+   void setFecEngine( FecEngine e ) { _fecEngine = e; }
+   // Words simulated per round and kept per gate, SIM_ROUND_WORDS by
+   // default.  The threads only share out the words of a round, so the
+   // patterns and the FEC groups do not depend on their number.
+   static const unsigned SIM_ROUND_WORDS = 8;
+   void setSimWords( unsigned k ) { _simWordsSet = k; }
+   void benchFECs( unsigned rounds );
+   const CirFecGrps& getFecGrps() const { return _fecGrps; }
+   // Every gate keeps a signature of the words simulated in the latest
+   // round (a random round or a block of pattern words); each round
+   // overwrites all of them.  The FEC groups agree with the first
+   // getSimWords() of them.  Word 0 is the one a single-word simulation
+   // works on.  All zeros for gates not in the DFS list.
+   unsigned getSimWords() const { return _simWordsUsed; }
+   const SimWord& getSimValue( unsigned gid, unsigned k = 0 ) const {
+      unsigned n = _flat.node( gid );
+      return ( n < _flat.nodeNum() && k < _simWords )?
+         _simValues[ k * _flat.nodeNum() + n ]: _zeroSim;
    }
+   // true if the signature of "b" is the complement of that of "a"
+   bool isSimInv( unsigned a, unsigned b ) const;
 
 
    // Member functions about fraig
-   void strash();
    void printFEC() const;
    void fraig();
+   // Conflicts and propagations a proof may take before it is put off
+   // and retried with more, and seconds the whole fraig may take; 0 for
+   // no limit.  Pairs still undecided in the end are left unmerged.
+   void setFraigBudget( unsigned c ) { _fraigBudget = c; }
+   void setFraigProps( unsigned p ) { _fraigProps = p; }
+   void setFraigTime( unsigned secs ) { _fraigTime = secs; }
+   // The restarts of the fraig solvers, and whether they keep the
+   // learnts of low LBD rather than the most active ones
+   void setFraigRestart( FraigRestart r ) { _fraigRestart = r; }
+   void setFraigLbd( bool l ) { _fraigLbd = l; }
 
    // Member functions about circuit reporting
    void printSummary() const;
@@ -63,8 +112,21 @@ public:
    void printFloatGates() const;
    void printFECPairs() const;
    void writeAag(ostream&) const;
+   void writeAig(ostream&) const;
 
 private:
+   // parsing private
+   bool readHeader();
+   bool readInputs();
+   bool readOutputs( IdList& lits );
+   bool readAigs( IdList& lits );
+   bool readBinaryAigs( IdList& lits );
+   bool readAigsParallel( IdList& lits );
+   bool readSymbols();
+   bool checkDefLit( unsigned lit, const char* type ) const;
+   bool connectFanin( CirGate& g, unsigned lit );
+
+   void buildFanouts();
    void dfsTraversal();
 
    void gateFuneral( unsigned );
@@ -73,24 +135,47 @@ private:
    void locateUnused() const;
    void cleanLists();
 
+   // structural hashing
+   void strash();
+   StrashKey strashKey( const CirGate* g ) const;
+   bool isStrashed( unsigned gid, const StrashKey& k ) const;
+   void strashGates( GateList& work );
+   void strashFanouts( const CirGate* g );
+
    //simulation private
-   void initPIs( vector<unsigned>& );
+   void initPIs( vector<SimWord>& );
+   unsigned roundWords() const { return _simWordsSet; }
+   void resizeSimWords( unsigned k );
+   SimWord* simWord( unsigned k ) {
+      return &_simValues[ k * _flat.nodeNum() ];
+   }
+   void simFileWords( const IdList& counts );
    bool initFECs();
    void firstSim();
    bool justSim();
-   bool updateFECs();
-   void printSimLog( unsigned til = 8 * sizeof(unsigned) );
+   bool simEvents( const IdList& srcs );
+   void syncSimPIs();
+   void simBatches( vector<SimBatchTask>& tasks );
+   bool updateFECs( const vector<const SimWord*>& vals );
+   void partitionFecGrp( const vector<const SimWord*>& vals, unsigned g );
+   bool flushCexs();
+   bool refineFECs( const SimWord* val, const IdList& grps );
+   void printSimLog( unsigned til = SimWord::BITS, const SimWord* val = 0 );
    unsigned maxFail();
 
    //void debugSim();
 
    //fraig private
-   void fraigBFS();
-   void fraigByDFS();
-
-   void genProofModel( SatSolver& );
-   bool checkEqv( SatSolver& s, unsigned, unsigned, bool isInv ) const;
-   bool packInputs( const SatSolver& );
+   void fraigRanked();
+   void fraigParallel();
+   unsigned fraigLead( unsigned g ) const;
+   void fraigCands( vector<FraigCand>& cands ) const;
+   bool sameFec( unsigned a, unsigned b ) const;
+
+   FraigResult checkEqv( FraigProver& p, unsigned, unsigned, bool isInv ) const;
+   void leaveUnresolved( unsigned a, unsigned b, bool isInv );
+   bool packInputs( const FraigProver&, unsigned a, unsigned b );
+   bool addCex( const vector<char>& pis, unsigned a, unsigned b );
    void killFecGrp( unsigned id );
    void mergeStrashGates( CirGate* persistG, CirGate* dyingG );
    void mergeEqvGates( unsigned persist, unsigned dying );
@@ -113,13 +198,32 @@ private:
 
    vector<CirGate*> _AllList;
    vector<CirGate*> _DFSList;
+   CirFlatAig _flat;
+   vector<SimWord> _simValues;   // word k of node n at [k * nodeNum + n]
+   unsigned _simWords;           // words per node in _simValues
+   unsigned _simWordsUsed;       // of them, the ones the FECs agree with
+   unsigned _simWordsSet;
+   vector<SimWord> _simPIs;      // PI words _simValues comes from
+   bool _simSynced;              // false: _simValues may be stale
+   static const SimWord _zeroSim;
+   ThreadPool _pool;
+   CirCexBuf _cexBuf;
    mutable IdList _FloatingList;
    mutable IdList _UnusedList;
 
-   vector< IdList* > _fecGrps;
+   Hash<StrashKey, unsigned> _strash;   // fanins -> AIG
+   CirFecGrps _fecGrps;
+   FecEngine _fecEngine;
+   unsigned _fraigBudget;
+   unsigned _fraigProps;
+   unsigned _fraigTime;
+   FraigRestart _fraigRestart;
+   bool _fraigLbd;
+   unsigned _unresolved;         // pairs of the last fraig left undecided
    bool _simmed;
 
-   ofstream *_simLog;
+   CirPatternWriter *_simLog;
+   CirPatternWriter *_simPack;
    unsigned _maxId;
    unsigned _piNum;
    unsigned _latNum;
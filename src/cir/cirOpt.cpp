@@ -65,14 +65,20 @@ CirMgr::sweep()
 }
 
 // Recursively simplifying from POs;
-// _dfsList needs to be reconstructed afterwards
+// _dfsList needs to be reconstructed afterwards.  A fanout of a removed
+// gate may turn out equal to another AIG, and be strashed away.
 void
 CirMgr::optimize()
 {
 	for ( size_t i = 0; i < _DFSList.size(); ++i ) {
-		if ( _DFSList[i]->selfOptimize( _AllList[0] ) ) {
-			_AllList[ _DFSList[i]->getId() ] = 0;
+		CirGate* g = _DFSList[i];
+		if ( _AllList[ g->getId() ] != g ) {
+			continue;
+		}
+		if ( g->selfOptimize( _AllList[0] ) ) {
+			_AllList[ g->getId() ] = 0;
 			--_aigNum;
+			strashFanouts( g );
 		}
 	}
 	cleanLists();
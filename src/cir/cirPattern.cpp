@@ -0,0 +1,454 @@
+/****************************************************************************
+  FileName     [ cirPattern.cpp ]
+  PackageName  [ cir ]
+  Synopsis     [ Define the pattern file reader and writer functions ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2008-2013 LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#include <cassert>
+#include <cstring>
+#include <sstream>
+#include "cirPattern.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+/**************************************/
+/*   Static varaibles and functions   */
+/**************************************/
+static const char PACKED_MAGIC[] = "FRAIGPAT";
+static const size_t PACKED_HEADER = 16;
+static const char LOG_MAGIC[] = "FRAIGLOG";
+static const size_t LOG_HEADER = 24;
+static const unsigned BLOCK_BITS = 64;
+
+static inline bool
+isBlank( char c )
+{
+	return c == ' ' || ( c >= '\t' && c <= '\r' );
+}
+
+static inline unsigned
+loadLE32( const char* p )
+{
+	const unsigned char* b = (const unsigned char*)p;
+	return unsigned( b[0] ) | ( unsigned( b[1] ) << 8 ) |
+	       ( unsigned( b[2] ) << 16 ) | ( unsigned( b[3] ) << 24 );
+}
+
+static inline SimChunk
+loadLE64( const char* p )
+{
+	SimChunk v;
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+	memcpy( &v, p, sizeof(v) );
+#else
+	v = 0;
+	for ( int i = 7; i >= 0; --i ) {
+		v = ( v << 8 ) | (unsigned char)p[i];
+	}
+#endif
+	return v;
+}
+
+static void
+storeLE( char* b, SimChunk v, unsigned bytes )
+{
+	for ( unsigned i = 0; i < bytes; ++i, v >>= 8 ) {
+		b[i] = char( v & 0xff );
+	}
+}
+
+// Bit i of the result is 1 if p[i] is '1', for i < "w" (at most 64);
+// "bad" is set if any of them is neither '0' nor '1'
+static inline SimChunk
+packRow( const char* p, unsigned w, bool& bad )
+{
+	SimChunk bits = 0;
+	unsigned i = 0;
+#if defined(__AVX2__)
+	for ( ; i + 32 <= w; i += 32 ) {
+		__m256i x = _mm256_loadu_si256( (const __m256i*)( p + i ) );
+		__m256i one = _mm256_cmpeq_epi8( x, _mm256_set1_epi8( '1' ) );
+		__m256i zero = _mm256_cmpeq_epi8( x, _mm256_set1_epi8( '0' ) );
+		bad |= ( unsigned( _mm256_movemask_epi8(
+		            _mm256_or_si256( one, zero ) ) ) != 0xffffffffu );
+		bits |= SimChunk( unsigned( _mm256_movemask_epi8( one ) ) ) << i;
+	}
+#endif
+#if defined(__SSE2__)
+	for ( ; i + 16 <= w; i += 16 ) {
+		__m128i x = _mm_loadu_si128( (const __m128i*)( p + i ) );
+		__m128i one = _mm_cmpeq_epi8( x, _mm_set1_epi8( '1' ) );
+		__m128i zero = _mm_cmpeq_epi8( x, _mm_set1_epi8( '0' ) );
+		bad |= ( _mm_movemask_epi8( _mm_or_si128( one, zero ) ) != 0xffff );
+		bits |= SimChunk( _mm_movemask_epi8( one ) ) << i;
+	}
+#endif
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+	// 8 characters at a time: '0'/'1' become bytes 0/1, and the multiply
+	// gathers byte k into bit 56 + k
+	for ( ; i + 8 <= w; i += 8 ) {
+		SimChunk v;
+		memcpy( &v, p + i, sizeof(v) );
+		v ^= 0x3030303030303030ULL;
+		bad |= ( ( v & 0xfefefefefefefefeULL ) != 0 );
+		bits |= ( ( v * 0x0102040810204080ULL ) >> 56 ) << i;
+	}
+#endif
+	for ( ; i < w; ++i ) {
+		bad |= ( p[i] != '0' && p[i] != '1' );
+		bits |= SimChunk( p[i] == '1' ) << i;
+	}
+	return bits;
+}
+
+// Transposes the 64 x 64 bit matrix whose row r is a[r], bit c of a row
+// being column c, by swapping ever smaller blocks
+static void
+transpose64( SimChunk* a )
+{
+	SimChunk m = 0x00000000ffffffffULL;
+	for ( unsigned j = 32; j != 0; j >>= 1, m ^= ( m << j ) ) {
+		for ( unsigned k = 0; k < 64; k = ( k + j + 1 ) & ~j ) {
+			SimChunk t = ( ( a[k] >> j ) ^ a[k + j] ) & m;
+			a[k] ^= t << j;
+			a[k + j] ^= t;
+		}
+	}
+}
+
+/***********************************************/
+/*   class CirPatternReader member functions   */
+/***********************************************/
+bool
+CirPatternReader::open( const string& fileName )
+{
+	_pos = 0;
+	_packed = false;
+	_packedPIs = _packedNum = _packedDone = 0;
+	if ( !_file.open( fileName ) ) {
+		return false;
+	}
+	if ( _file.size() >= PACKED_HEADER &&
+	     memcmp( _file.begin(), PACKED_MAGIC, 8 ) == 0 ) {
+		_packed = true;
+		_packedPIs = loadLE32( _file.begin() + 8 );
+		_packedNum = loadLE32( _file.begin() + 12 );
+	}
+	return true;
+}
+
+CirPatternReader::Status
+CirPatternReader::read( SimWord* pis, unsigned piNum, unsigned& count )
+{
+	count = 0;
+	return _packed? readPacked( pis, piNum, count ):
+	                readText( pis, piNum, count );
+}
+
+// A word at a time: the patterns are located first, then each 64 x 64
+// block of (pattern, PI) bits is packed by rows and transposed into the
+// PI words.  The characters are checked while they are packed.
+CirPatternReader::Status
+CirPatternReader::readText( SimWord* pis, unsigned piNum, unsigned& count )
+{
+	const char* p = _file.begin() + _pos;
+	const char* end = _file.end();
+	_rows.resize( SimWord::BITS );
+	while ( count < SimWord::BITS ) {
+		while ( p != end && isBlank( *p ) ) {
+			++p;
+		}
+		if ( p == end ) {
+			break;
+		}
+		const char* t = p;
+		while ( p != end && !isBlank( *p ) ) {
+			++p;
+		}
+		if ( size_t( p - t ) != piNum ) {
+			_badPattern.assign( t, p );
+			_pos = p - _file.begin();
+			return PAT_LENGTH;
+		}
+		_rows[count++] = t;
+	}
+	_pos = p - _file.begin();
+	if ( count == 0 ) {
+		return PAT_END;
+	}
+
+	bool bad = false;
+	SimChunk m[BLOCK_BITS];
+	for ( unsigned c = 0; c < SimWord::CHUNKS; ++c ) {
+		unsigned first = c * BLOCK_BITS;
+		unsigned rowNum = ( count <= first )? 0: count - first;
+		if ( rowNum > BLOCK_BITS ) {
+			rowNum = BLOCK_BITS;
+		}
+		for ( unsigned b = 0; b < piNum; b += BLOCK_BITS ) {
+			unsigned w = ( piNum - b < BLOCK_BITS )? piNum - b: BLOCK_BITS;
+			if ( rowNum == 0 ) {
+				for ( unsigned i = 0; i < w; ++i ) {
+					pis[b + i].setChunk( c, 0 );
+				}
+				continue;
+			}
+			for ( unsigned r = 0; r < BLOCK_BITS; ++r ) {
+				m[r] = ( r < rowNum )? packRow( _rows[first + r] + b, w, bad ): 0;
+			}
+			transpose64( m );
+			for ( unsigned i = 0; i < w; ++i ) {
+				pis[b + i].setChunk( c, m[i] );
+			}
+		}
+	}
+	if ( bad ) {
+		findBadChar( piNum, count );
+		return PAT_CHAR;
+	}
+	return PAT_OK;
+}
+
+// The first bad character PI by PI, then pattern by pattern, as the
+// character-wise reader used to report it
+void
+CirPatternReader::findBadChar( unsigned piNum, unsigned count )
+{
+	for ( unsigned i = 0; i < piNum; ++i ) {
+		for ( unsigned j = 0; j < count; ++j ) {
+			char c = _rows[j][i];
+			if ( c != '0' && c != '1' ) {
+				_badPattern.assign( _rows[j], piNum );
+				_badChar = c;
+				return;
+			}
+		}
+	}
+	assert( 0 );
+}
+
+CirPatternReader::Status
+CirPatternReader::readPacked( SimWord* pis, unsigned piNum, unsigned& count )
+{
+	size_t blockBytes = size_t( piNum ) * sizeof(SimChunk);
+	if ( _packedPIs != piNum ) {
+		stringstream ss;
+		ss << "the packed patterns have " << _packedPIs
+		   << " inputs, the circuit " << piNum;
+		_error = ss.str();
+		return PAT_FORMAT;
+	}
+	if ( _packedDone == 0 && PACKED_HEADER + blockBytes *
+	     ( ( size_t( _packedNum ) + BLOCK_BITS - 1 ) / BLOCK_BITS ) >
+	     _file.size() ) {
+		_error = "the packed pattern file is truncated";
+		return PAT_FORMAT;
+	}
+	if ( _packedDone >= _packedNum ) {
+		return PAT_END;
+	}
+
+	count = _packedNum - _packedDone;
+	if ( count > SimWord::BITS ) {
+		count = SimWord::BITS;
+	}
+	const char* blk = _file.begin() + PACKED_HEADER +
+	                  ( _packedDone / BLOCK_BITS ) * blockBytes;
+	for ( unsigned c = 0; c < SimWord::CHUNKS; ++c, blk += blockBytes ) {
+		unsigned first = c * BLOCK_BITS;
+		if ( count <= first ) {
+			for ( unsigned i = 0; i < piNum; ++i ) {
+				pis[i].setChunk( c, 0 );
+			}
+			continue;
+		}
+		SimChunk mask = ( count - first >= BLOCK_BITS )? ~SimChunk(0):
+		                ( SimChunk(1) << ( count - first ) ) - 1;
+		for ( unsigned i = 0; i < piNum; ++i ) {
+			pis[i].setChunk( c, loadLE64( blk + i * sizeof(SimChunk) ) & mask );
+		}
+	}
+	_packedDone += count;
+	return PAT_OK;
+}
+
+/***********************************************/
+/*   class CirPatternWriter member functions   */
+/***********************************************/
+bool
+CirPatternWriter::open( const string& fileName, Format f, unsigned piNum,
+                        unsigned poNum )
+{
+	close();
+	if ( !_file.open( fileName ) ) {
+		return false;
+	}
+	_format = f;
+	_piNum = piNum;
+	_poNum = ( f == PACKED )? 0: poNum;
+	_patternNum = 0;
+	_fill = 0;
+	_block.assign( _piNum + _poNum, 0 );
+	_carry.assign( _piNum + _poNum, 0 );
+	// the header is rewritten by close(), with the pattern number
+	if ( _format != LOG_TEXT ) {
+		string head = header();
+		_file.write( head.data(), head.size() );
+	}
+	return true;
+}
+
+void
+CirPatternWriter::write( const SimWord* pis, const SimWord* pos,
+                         unsigned count )
+{
+	if ( _format == LOG_TEXT ) {
+		writeText( pis, pos, count );
+		return;
+	}
+	for ( unsigned c = 0; c < SimWord::CHUNKS; ++c ) {
+		unsigned first = c * BLOCK_BITS;
+		if ( count <= first ) {
+			break;
+		}
+		unsigned n = ( count - first > BLOCK_BITS )? BLOCK_BITS: count - first;
+		SimChunk mask = ( n == BLOCK_BITS )? ~SimChunk(0):
+		                ( SimChunk(1) << n ) - 1;
+		unsigned room = BLOCK_BITS - _fill;
+		for ( unsigned i = 0; i < _block.size(); ++i ) {
+			const SimWord& w = ( i < _piNum )? pis[i]: pos[i - _piNum];
+			SimChunk v = w.chunk(c) & mask;
+			_block[i] |= v << _fill;
+			_carry[i] = ( n > room )? v >> room: 0;
+		}
+		if ( n < room ) {
+			_fill += n;
+		}
+		else {
+			flushBlock();
+			_block.swap( _carry );
+			_fill = n - room;
+		}
+		_patternNum += n;
+	}
+}
+
+// The characters of the bytes: chars[b] is "b" as 8 '0'/'1' characters,
+// bit 0 first, ready to be copied out 8 bytes at a time
+struct BitChars
+{
+	char chars[256][8];
+
+	BitChars() {
+		for ( unsigned b = 0; b < 256; ++b ) {
+			for ( unsigned i = 0; i < 8; ++i ) {
+				chars[b][i] = ( ( b >> i ) & 1 )? '1': '0';
+			}
+		}
+	}
+};
+static const BitChars bitChars;
+
+// Puts the first "n" patterns of the "num" words into the lines at "out",
+// "len" characters a line, from column "col" on
+static void
+putColumns( char* out, unsigned len, unsigned col, const SimWord* words,
+            unsigned num, unsigned c, unsigned n )
+{
+	SimChunk m[BLOCK_BITS];
+	for ( unsigned b = 0; b < num; b += BLOCK_BITS ) {
+		unsigned w = ( num - b < BLOCK_BITS )? num - b: BLOCK_BITS;
+		for ( unsigned i = 0; i < BLOCK_BITS; ++i ) {
+			m[i] = ( i < w )? words[b + i].chunk(c): 0;
+		}
+		transpose64( m );
+		for ( unsigned r = 0; r < n; ++r ) {
+			char* dst = out + size_t( r ) * len + col + b;
+			SimChunk bits = m[r];
+			unsigned i = 0;
+			for ( ; i + 8 <= w; i += 8, bits >>= 8 ) {
+				memcpy( dst + i, bitChars.chars[ bits & 0xff ], 8 );
+			}
+			for ( ; i < w; ++i, bits >>= 1 ) {
+				dst[i] = ( bits & 1 )? '1': '0';
+			}
+		}
+	}
+}
+
+// A chunk of 64 patterns at a time: the PI and PO words are transposed
+// by 64 x 64 blocks right into the lines
+void
+CirPatternWriter::writeText( const SimWord* pis, const SimWord* pos,
+                             unsigned count )
+{
+	unsigned len = _piNum + _poNum + 2;
+	for ( unsigned c = 0; c < SimWord::CHUNKS; ++c ) {
+		unsigned first = c * BLOCK_BITS;
+		if ( count <= first ) {
+			break;
+		}
+		unsigned n = ( count - first > BLOCK_BITS )? BLOCK_BITS: count - first;
+		char* out = _file.reserve( size_t( n ) * len );
+		for ( unsigned r = 0; r < n; ++r ) {
+			out[ size_t( r ) * len + _piNum ] = ' ';
+			out[ size_t( r ) * len + len - 1 ] = '\n';
+		}
+		putColumns( out, len, 0, pis, _piNum, c, n );
+		putColumns( out, len, _piNum + 1, pos, _poNum, c, n );
+		_file.commit( size_t( n ) * len );
+		_patternNum += n;
+	}
+}
+
+void
+CirPatternWriter::flushBlock()
+{
+	char* out = _file.reserve( _block.size() * sizeof(SimChunk) );
+	for ( unsigned i = 0; i < _block.size(); ++i ) {
+		storeLE( out + i * sizeof(SimChunk), _block[i], sizeof(SimChunk) );
+		_block[i] = 0;
+	}
+	_file.commit( _block.size() * sizeof(SimChunk) );
+	_fill = 0;
+}
+
+string
+CirPatternWriter::header() const
+{
+	char b[LOG_HEADER];
+	size_t n = ( _format == PACKED )? PACKED_HEADER: LOG_HEADER;
+	memcpy( b, ( _format == PACKED )? PACKED_MAGIC: LOG_MAGIC, 8 );
+	storeLE( b + 8, _piNum, 4 );
+	storeLE( b + 12, _patternNum, 4 );
+	if ( _format == LOG_PACKED ) {
+		storeLE( b + 16, _poNum, 4 );
+		storeLE( b + 20, 0, 4 );
+	}
+	return string( b, n );
+}
+
+bool
+CirPatternWriter::close()
+{
+	if ( !_file.isOpen() ) {
+		return true;
+	}
+	if ( _format == LOG_TEXT ) {
+		return _file.close();
+	}
+	if ( _fill != 0 ) {
+		flushBlock();
+	}
+	string head = header();
+	return _file.close( head.data(), head.size() );
+}
@@ -0,0 +1,121 @@
+/****************************************************************************
+  FileName     [ cirPattern.h ]
+  PackageName  [ cir ]
+  Synopsis     [ Define the simulation pattern file reader and writer ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2008-2013 LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#ifndef CIR_PATTERN_H
+#define CIR_PATTERN_H
+
+#include <string>
+#include <vector>
+#include "cirSimWord.h"
+#include "myMappedFile.h"
+#include "myAsyncWriter.h"
+
+using namespace std;
+
+// Two pattern file formats are read:
+//
+// Text: whitespace separated patterns, one '0'/'1' per PI.
+//
+// Packed: the 16-byte header
+//    "FRAIGPAT"   magic
+//    uint32       number of PIs
+//    uint32       number of patterns, "n"
+// then (n + 63) / 64 blocks of 64 patterns.  A block is one uint64 per
+// PI, bit j of it the value in pattern j of the block; the bits past the
+// last pattern are 0.  All the numbers are little-endian.  A block is a
+// chunk of a simulation word as it is, so nothing has to be transposed.
+class CirPatternReader
+{
+public:
+   enum Status
+   {
+      PAT_OK,
+      PAT_END,       // no pattern left
+      PAT_LENGTH,    // a text pattern of the wrong length
+      PAT_CHAR,      // a text pattern with a non-0/1 character
+      PAT_FORMAT     // a bad packed file; see error()
+   };
+
+   CirPatternReader() : _pos(0), _packed(false), _packedPIs(0),
+                        _packedNum(0), _packedDone(0), _badChar(0) {}
+   ~CirPatternReader() {}
+
+   bool open( const string& fileName );
+   bool isPacked() const { return _packed; }
+
+   // Reads up to SimWord::BITS patterns into "pis[0, piNum)", one word
+   // per PI; "count" gets the number read.  On PAT_LENGTH / PAT_CHAR,
+   // badPattern() (and badChar()) tell the offending pattern.
+   Status read( SimWord* pis, unsigned piNum, unsigned& count );
+
+   const string& badPattern() const { return _badPattern; }
+   char badChar() const { return _badChar; }
+   const string& error() const { return _error; }
+
+private:
+   Status readText( SimWord* pis, unsigned piNum, unsigned& count );
+   Status readPacked( SimWord* pis, unsigned piNum, unsigned& count );
+   void findBadChar( unsigned piNum, unsigned count );
+
+   MappedFile            _file;
+   size_t                _pos;
+   bool                  _packed;
+   unsigned              _packedPIs;
+   unsigned              _packedNum;
+   unsigned              _packedDone;
+   vector<const char*>   _rows;      // the text patterns of a word
+   string                _badPattern;
+   char                  _badChar;
+   string                _error;
+};
+
+// Writes simulation words out, through a background thread:
+//
+// PACKED      a packed pattern file, as above
+// LOG_TEXT    the simulation log: a line per pattern, its PI values, a
+//             space and its PO values
+// LOG_PACKED  the packed layout with a 24-byte header
+//                "FRAIGLOG", uint32 PIs, uint32 patterns, uint32 POs, 0
+//             and the PO words after the PI words in each block
+class CirPatternWriter
+{
+public:
+   enum Format
+   {
+      PACKED,
+      LOG_TEXT,
+      LOG_PACKED
+   };
+
+   CirPatternWriter() : _format(PACKED), _piNum(0), _poNum(0),
+                        _patternNum(0), _fill(0) {}
+   ~CirPatternWriter() { close(); }
+
+   bool open( const string& fileName, Format f, unsigned piNum,
+              unsigned poNum = 0 );
+   // the first "count" patterns of "pis[0, piNum)" and "pos[0, poNum)"
+   void write( const SimWord* pis, const SimWord* pos, unsigned count );
+   // false if any write to the file failed
+   bool close();
+
+private:
+   void writeText( const SimWord* pis, const SimWord* pos, unsigned count );
+   void flushBlock();
+   string header() const;
+
+   AsyncWriter         _file;
+   Format              _format;
+   unsigned            _piNum;
+   unsigned            _poNum;
+   unsigned            _patternNum;
+   unsigned            _fill;       // patterns in _block
+   vector<SimChunk>    _block;      // a word per PI, then per PO
+   vector<SimChunk>    _carry;      // what overflows _block
+};
+
+#endif // CIR_PATTERN_H
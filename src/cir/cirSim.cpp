@@ -13,8 +13,13 @@
 #include <climits>
 #include <sstream>
 #include <stdexcept>
+#include <algorithm>
+#include <queue>
+#include <functional>
+#include <ctime>
 #include "cirMgr.h"
 #include "cirGate.h"
+#include "cirPattern.h"
 #include "myHash.h"
 #include "util.h"
 
@@ -27,38 +32,81 @@ using namespace std;
 class FirstSimKey
 {
 public:
-	FirstSimKey( unsigned s ): _simR(s) { 
-		if ( _simR & _mask ) {
+	FirstSimKey( const SimWord& s ): _simR(s) { 
+		if ( _simR.bit(0) ) {
 			_simR = ~_simR;
 		}
 	}
 
 	size_t operator () () const {
-		return ( _simR + ( _simR << 1 ) + ( _simR << 2 ) );
+		return _simR.hash();
 	}
 
 	bool operator == ( const FirstSimKey& k ) const {
 		return ( _simR == k._simR ); 
 	}
 private: 
-	unsigned _simR;
-	static const unsigned _mask = 1;
+	SimWord _simR;
 };
 
+// Signature of a gate over one or more pattern batches, taken in its FEC
+// phase; every batch is a value array indexed by CirFlatAig node.  The
+// old FEC group is part of the key, so one hash serves all the groups.
 class SimKey
 {
 public:
-	SimKey( unsigned s ): _simR(s) { }
+	SimKey( const vector<const SimWord*>& v, unsigned n, bool inv,
+	        unsigned grp )
+		: _vals(&v), _node(n), _inv(inv), _grp(grp) { }
 
 	size_t operator () () const {
-		return ( _simR + ( _simR << 1 ) + ( _simR << 2 ) );
+		size_t h = _grp;
+		for ( size_t b = 0; b < _vals->size(); ++b ) {
+			h = h * 31 + value(b).hash();
+		}
+		return h;
 	}
 
 	bool operator == ( const SimKey& k ) const {
-		return ( _simR == k._simR ); 
+		if ( _grp != k._grp ) {
+			return false;
+		}
+		for ( size_t b = 0; b < _vals->size(); ++b ) {
+			if ( value(b) != k.value(b) ) {
+				return false;
+			}
+		}
+		return true;
 	}
 private: 
-	unsigned _simR;
+	SimWord value( size_t b ) const {
+		return (*_vals)[b][_node] ^ SimWord::mask( _inv );
+	}
+
+	const vector<const SimWord*>* _vals;
+	unsigned _node;
+	bool _inv;
+	unsigned _grp;
+};
+
+// Simulates one batch of random patterns in its own value array, with its
+// own generator, so that batches can run on different threads
+class SimBatchTask : public ThreadTask
+{
+public:
+	SimBatchTask( const CirFlatAig* a, SimWord* v, unsigned seed )
+		: _aig(a), _val(v), _rnGen(seed) { }
+
+	void run( unsigned ) {
+		for ( unsigned i = 0; i < _aig->piNum(); ++i ) {
+			_val[ _aig->piNode(i) ].random( _rnGen );
+		}
+		_aig->simulate( _val );
+	}
+private:
+	const CirFlatAig* _aig;
+	SimWord* _val;
+	LocalRandomNumGen _rnGen;
 };
 
 class LengthException : public runtime_error
@@ -92,6 +140,246 @@ private:
 /**************************************/
 /*   Static varaibles and functions   */
 /**************************************/
+const SimWord CirMgr::_zeroSim;
+const unsigned CirMgr::SIM_ROUND_WORDS;
+
+// Scratch of the FEC refinement, kept over the rounds so that a round
+// allocates nothing once it has grown: the members visited, in order, the
+// new group (key) of each, and the size of each new group
+static Hash< FirstSimKey, unsigned > firstHash;
+static Hash< SimKey, unsigned > fecHash;
+static IdList fecIds;
+static IdList fecSlot;
+static IdList fecCount;
+static IdList fecFill;
+
+// Scratch of the sort engine, for the group being split: the members,
+// their literals ( 2 * node + FEC phase ), the keys sorted and the run of
+// equal signatures each member falls in
+struct FecSortEntry
+{
+	SimChunk _key;
+	unsigned _pos;
+
+	bool operator < ( const FecSortEntry& e ) const {
+		return ( _key < e._key ) || ( _key == e._key && _pos < e._pos );
+	}
+};
+static IdList fecMembers;
+static IdList fecLits;
+static vector<FecSortEntry> fecKeys;
+static vector<FecSortEntry> fecSorted;
+static IdList fecRadix;
+static IdList fecRun;
+static IdList fecReps;
+
+// Groups up to this size are sorted directly; larger ones are radix
+// partitioned on the top bits of the key first
+static const unsigned FEC_RADIX_MIN = 64;
+static const unsigned FEC_RADIX_BITS = 16;
+
+static void
+clearScratch()
+{
+	fecIds.clear();
+	fecSlot.clear();
+	fecCount.clear();
+}
+
+template <class K>
+static void
+prepareHash( Hash<K, unsigned>& h, size_t n )
+{
+	if ( h.numBuckets() < getHashSize( n / 5 ) ) {
+		h.init( n / 5 );
+	}
+	else {
+		h.clear();
+	}
+	clearScratch();
+}
+
+// Counts "id" in the new group of "key"
+template <class K>
+static void
+addMember( Hash<K, unsigned>& h, const K& key, unsigned id )
+{
+	unsigned k;
+	if ( !h.check( key, k ) ) {
+		k = fecCount.size();
+		fecCount.push_back( 0 );
+		h.forceInsert( key, k );
+	}
+	++fecCount[k];
+	fecIds.push_back( id );
+	fecSlot.push_back( k );
+}
+
+// True if the signature is a single chunk; its key then identifies it
+static inline bool
+exactKey( const vector<const SimWord*>& vals )
+{
+	return vals.size() * SimWord::CHUNKS == 1;
+}
+
+// Mixed by SimWord::mix(), so the top bits of a key are good radix digits
+static SimChunk
+sortKey( const vector<const SimWord*>& vals, unsigned lit )
+{
+	SimChunk inv = -SimChunk( lit & 1 );
+	if ( exactKey( vals ) ) {
+		return SimWord::mix( vals[0][ lit >> 1 ].chunk(0) ^ inv );
+	}
+	SimChunk h = 0;
+	for ( size_t b = 0; b < vals.size(); ++b ) {
+		const SimWord& w = vals[b][ lit >> 1 ];
+		for ( unsigned i = 0; i < SimWord::CHUNKS; ++i ) {
+			h = SimWord::mix( h + ( w.chunk(i) ^ inv ) );
+		}
+	}
+	return h;
+}
+
+static bool
+sameSignature( const vector<const SimWord*>& vals, unsigned a, unsigned b )
+{
+	SimWord inv = SimWord::mask( ( a ^ b ) & 1 );
+	for ( size_t k = 0; k < vals.size(); ++k ) {
+		if ( vals[k][ a >> 1 ] != ( vals[k][ b >> 1 ] ^ inv ) ) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// Splits the group in fecMembers/fecLits and counts it into the scratch
+// just as addMember() would, member by member: the new groups get their
+// slots in the order of their first members.  The keys are sorted, after
+// a radix pass on the top bits for a large group, so that equal
+// signatures end up next to each other; with hashed keys each run is
+// checked word by word, in case two signatures share a key.
+static void
+addGroupBySort( const vector<const SimWord*>& vals )
+{
+	unsigned n = fecMembers.size();
+	fecKeys.resize( n );
+	for ( unsigned j = 0; j < n; ++j ) {
+		fecKeys[j]._key = sortKey( vals, fecLits[j] );
+		fecKeys[j]._pos = j;
+	}
+
+	if ( n <= FEC_RADIX_MIN ) {
+		sort( fecKeys.begin(), fecKeys.end() );
+		fecSorted.swap( fecKeys );
+	}
+	else {
+		unsigned bits = 1;
+		while ( bits < FEC_RADIX_BITS && ( 1u << bits ) < n ) {
+			++bits;
+		}
+		unsigned shift = 8 * sizeof(SimChunk) - bits;
+		fecRadix.assign( ( 1u << bits ) + 1, 0 );
+		for ( unsigned j = 0; j < n; ++j ) {
+			++fecRadix[ ( fecKeys[j]._key >> shift ) + 1 ];
+		}
+		for ( size_t d = 1; d < fecRadix.size(); ++d ) {
+			fecRadix[d] += fecRadix[d - 1];
+		}
+		fecSorted.resize( n );
+		for ( unsigned j = 0; j < n; ++j ) {
+			fecSorted[ fecRadix[ fecKeys[j]._key >> shift ]++ ] = fecKeys[j];
+		}
+		// fecRadix[d] is now the end of digit d
+		unsigned b = 0;
+		for ( size_t d = 0; d + 1 < fecRadix.size(); ++d ) {
+			if ( fecRadix[d] - b > 1 ) {
+				sort( fecSorted.begin() + b, fecSorted.begin() + fecRadix[d] );
+			}
+			b = fecRadix[d];
+		}
+	}
+
+	unsigned runNum = 0;
+	fecRun.resize( n );
+	for ( unsigned b = 0, e; b < n; b = e ) {
+		for ( e = b + 1; e < n && fecSorted[e]._key == fecSorted[b]._key;
+		      ++e ) ;
+		if ( exactKey( vals ) ) {
+			for ( unsigned j = b; j < e; ++j ) {
+				fecRun[ fecSorted[j]._pos ] = runNum;
+			}
+			++runNum;
+			continue;
+		}
+		fecReps.clear();
+		for ( unsigned j = b; j < e; ++j ) {
+			unsigned pos = fecSorted[j]._pos;
+			unsigned r = 0;
+			while ( r < fecReps.size() &&
+			        !sameSignature( vals, fecLits[ fecReps[r] ],
+			                        fecLits[pos] ) ) {
+				++r;
+			}
+			if ( r == fecReps.size() ) {
+				fecReps.push_back( pos );
+			}
+			fecRun[pos] = runNum + r;
+		}
+		runNum += fecReps.size();
+	}
+
+	// slots by first member; fecReps maps a run to its slot
+	fecReps.assign( runNum, UINT_MAX );
+	for ( unsigned j = 0; j < n; ++j ) {
+		unsigned& k = fecReps[ fecRun[j] ];
+		if ( k == UINT_MAX ) {
+			k = fecCount.size();
+			fecCount.push_back( 0 );
+		}
+		++fecCount[k];
+		fecIds.push_back( fecMembers[j] );
+		fecSlot.push_back( k );
+	}
+}
+
+// Number of new groups of 2 or more members from key "first" on
+static unsigned
+keptGroups( unsigned first )
+{
+	unsigned n = 0;
+	for ( size_t k = first; k < fecCount.size(); ++k ) {
+		if ( fecCount[k] > 1 ) {
+			++n;
+		}
+	}
+	return n;
+}
+
+// Lays the new groups out in the second arena of "grps", in the order of
+// their keys, and swaps it in; groups of one member are dropped
+static void
+buildGroups( CirFecGrps& grps )
+{
+	unsigned n = 0;
+	grps.startNext();
+	for ( size_t k = 0; k < fecCount.size(); ++k ) {
+		if ( fecCount[k] > 1 ) {
+			fecCount[k] = grps.addNext( fecCount[k] );
+			++n;
+		}
+		else {
+			fecCount[k] = UINT_MAX;
+		}
+	}
+	fecFill.assign( n, 0 );
+	for ( size_t i = 0; i < fecIds.size(); ++i ) {
+		unsigned g = fecCount[ fecSlot[i] ];
+		if ( g != UINT_MAX ) {
+			grps.nextId( g, fecFill[g]++ ) = fecIds[i];
+		}
+	}
+	grps.swapNext();
+}
 
 /************************************************/
 /*   Public member functions about Simulation   */
@@ -103,81 +391,90 @@ CirMgr::randomSim()
 	cout << "MAX_FAILS = " << max << endl;
 	unsigned fail = 0;
 	unsigned trial = 0;
+
+	// One batch per word of the signatures, simulated right into its
+	// slice of _simValues; the batches run on the simulation threads.
+	unsigned batchNum = roundWords();
+	resizeSimWords( batchNum );
+	vector<const SimWord*> vals;
+	vector<SimBatchTask> tasks;
+	tasks.reserve( batchNum );
+	for ( unsigned b = 0; b < batchNum; ++b ) {
+		vals.push_back( simWord(b) );
+		tasks.push_back( SimBatchTask( &_flat, simWord(b), rnGen(INT_MAX) ) );
+	}
+
 	if ( !_simmed ) {
-		for ( size_t i = 0; i < _piNum; ++i ) {
-			_PIs[i].initSim( rnGen(INT_MAX) );
+		simBatches( tasks );
+		syncSimPIs();
+		initFECs();
+		_simmed = true;
+		if ( batchNum > 1 ) {
+			vector<const SimWord*> rest( vals.begin() + 1, vals.end() );
+			updateFECs( rest );
 		}
-		firstSim();
+		_simWordsUsed = batchNum;
 	}
 	
 	while ( fail < max && !(_fecGrps.empty()) ) {
-		for ( size_t i = 0; i < _piNum; ++i ) {
-			_PIs[i].initSim( rnGen(INT_MAX) );
-		}
-		if ( !justSim() ) {
+		simBatches( tasks );
+		syncSimPIs();
+		if ( !updateFECs( vals ) ) {
 			++fail;
 		}
-		trial += 8 * sizeof(unsigned);
+		_simWordsUsed = batchNum;
+		trial += batchNum * SimWord::BITS;
 		
 		printFEC();
 		cout << '\r' ;
 
-		printSimLog();
+		for ( unsigned b = 0; b < batchNum; ++b ) {
+			printSimLog( SimWord::BITS, vals[b] );
+		}
 	}
 
 	cout << trial << " patterns simulated." << endl;
 	_simmed = true;
 }
 
+// The patterns go through CirPatternReader, text or packed alike, one
+// word of SimWord::BITS patterns at a time
 void
-CirMgr::fileSim(ifstream& patternFile)
+CirMgr::fileSim( CirPatternReader& patterns )
 {
 	size_t totalCount = 0;
-	vector<string> patterns( 8 * sizeof(unsigned) );
-	size_t count;
-	size_t input;
+	unsigned count;
+	unsigned words = roundWords();
+	IdList counts;   // patterns in each word of the block read so far
 
+	resizeSimWords( words );
 	try {
-	while ( patternFile ) {
-		for ( count = 0; count < patterns.size(); ++count ){
-			patternFile >> patterns[count];
-			if ( !patternFile ) {
-				break;
-			}
-			if ( patterns[count].length() != _piNum ) {
-				throw LengthException( 
-					patterns[count], _piNum );
-			}
-			++totalCount;
+	while ( true ) {
+		CirPatternReader::Status s = patterns.read( 
+			simWord( counts.size() ) + _flat.piNode(0), _piNum, count );
+		if ( s == CirPatternReader::PAT_END ) {
+			break;
 		}
-		if ( count == 0 ) { break; }
-
-		for ( size_t i = 0; i < _piNum; ++i ) {
-			input = 0;
-			for ( size_t j = 0; j < count; ++j ) {
-				if ( patterns[j][i] == '1' ) {
-					input += 1 << j;
-				}
-				else if ( patterns[j][i] != '0' ) {
-					throw CharException( 
-						patterns[j], patterns[j][i] );
-				}
-			}
-			_PIs[i].initSim( input );
+		if ( s == CirPatternReader::PAT_LENGTH ) {
+			throw LengthException( patterns.badPattern(), _piNum );
 		}
-		if ( !_simmed ) {
-			firstSim();
+		if ( s == CirPatternReader::PAT_CHAR ) {
+			throw CharException( patterns.badPattern(), patterns.badChar() );
 		}
-		else {
-			justSim();
+		if ( s == CirPatternReader::PAT_FORMAT ) {
+			throw runtime_error( patterns.error() );
 		}
-
-		printFEC();
-		cout << '\r' ;
-
-		printSimLog( count );
+		totalCount += count;
+		counts.push_back( count );
+		if ( counts.size() == words ) {
+			simFileWords( counts );
+			counts.clear();
 		}
 	}
+	if ( !counts.empty() ) {
+		simFileWords( counts );
+	}
+	}
 	catch( LengthException &lExcpt ) {
 		cerr << "Error: Pattern" 
 			 << "(" << lExcpt.getPattern() << ")" 
@@ -200,7 +497,12 @@ CirMgr::fileSim(ifstream& patternFile)
 		_simmed = false;
 		_fecGrps.clear();
 	}
-	patternFile.close();
+	catch( runtime_error &fmtExcept ) {
+		cerr << "Error: " << fmtExcept.what() << "!!" << endl;
+		totalCount = 0;
+		_simmed = false;
+		_fecGrps.clear();
+	}
 	if (_simLog) {	
 		_simLog->close();
 	}
@@ -209,15 +511,154 @@ CirMgr::fileSim(ifstream& patternFile)
 	//_simmed = true;
 }
 
+// Times the FEC refinement engines against each other.  Each one starts
+// the groups over and refines them by the same "rounds" words of random
+// patterns; the groups must come out the same.  The circuit is left
+// simulated, in the engine set before.
+void
+CirMgr::benchFECs( unsigned rounds )
+{
+	static const FecEngine engines[] = { FEC_HASH, FEC_SORT };
+	static const char* names[] = { "Hash", "Sort" };
+	FecEngine engine = _fecEngine;
+	unsigned seed = rnGen( INT_MAX );
+	vector<const SimWord*> vals( 1, &_simValues[0] );
+	vector<IdList> leads( 2 );
+	double times[2];
+	unsigned done = 0;
+	streamsize prec = cout.precision();
+
+	for ( unsigned e = 0; e < 2; ++e ) {
+		_fecEngine = engines[e];
+		SimBatchTask task( &_flat, &_simValues[0], seed );
+		clock_t ticks = 0;
+		done = 0;
+		for ( ; done < rounds; ++done ) {
+			if ( done != 0 && _fecGrps.empty() ) {
+				break;
+			}
+			task.run( 0 );
+			clock_t start = clock();
+			if ( done == 0 ) {
+				initFECs();
+			}
+			else {
+				updateFECs( vals );
+			}
+			ticks += clock() - start;
+		}
+		times[e] = double( ticks ) / CLOCKS_PER_SEC;
+
+		leads[e].assign( _AllList.size(), UINT_MAX );
+		for ( unsigned g = 0; g < _fecGrps.size(); ++g ) {
+			for ( unsigned j = 0; j < _fecGrps.grpSize(g); ++j ) {
+				leads[e][ _fecGrps.id( g, j ) ] = _fecGrps.id( g, 0 );
+			}
+		}
+		cout << names[e] << ": " << fixed << setprecision(4) << times[e]
+		     << " s, " << done << " rounds, " << _fecGrps.size()
+		     << " FEC groups" << endl;
+	}
+	cout.unsetf( ios::fixed );
+	if ( times[1] > 0 ) {
+		cout << "Speed-up (Hash / Sort): " << setprecision(3)
+		     << times[0] / times[1] << endl;
+	}
+	cout.precision( prec );
+	if ( leads[0] != leads[1] ) {
+		cerr << "Error: the FEC engines disagree!!" << endl;
+	}
+	cout << done * SimWord::BITS << " patterns simulated." << endl;
+
+	_fecEngine = engine;
+	syncSimPIs();
+	_simmed = true;
+}
+
+bool
+CirMgr::isSimInv( unsigned a, unsigned b ) const
+{
+	unsigned words = _simWordsUsed? _simWordsUsed: 1;
+	for ( unsigned k = 0; k < words; ++k ) {
+		if ( getSimValue( b, k ) != ~getSimValue( a, k ) ) {
+			return false;
+		}
+	}
+	return true;
+}
+
 /*************************************************/
 /*   Private member functions about Simulation   */
 /*************************************************/
+// Keeps "k" words per node, the first ones carried over
+void
+CirMgr::resizeSimWords( unsigned k )
+{
+	if ( k == _simWords ) {
+		return;
+	}
+	unsigned n = _flat.nodeNum();
+	vector<SimWord> values( k * n );
+	for ( unsigned w = 0; w < k && w < _simWords; ++w ) {
+		copy( _simValues.begin() + w * n, _simValues.begin() + ( w + 1 ) * n,
+		      values.begin() + w * n );
+	}
+	_simValues.swap( values );
+	_simWords = k;
+	if ( _simWordsUsed > k ) {
+		_simWordsUsed = k;
+	}
+}
+
+// Simulates the words of a block read by fileSim(), "counts[k]" patterns
+// in word k, and refines the FEC groups by all of them at once.  A block
+// of one word goes through firstSim() or justSim().
 void
-CirMgr::initPIs( vector<unsigned>& inputs )
+CirMgr::simFileWords( const IdList& counts )
+{
+	vector<const SimWord*> vals;
+	for ( size_t k = 0; k < counts.size(); ++k ) {
+		vals.push_back( simWord(k) );
+	}
+	if ( counts.size() == 1 ) {
+		if ( !_simmed ) {
+			firstSim();
+		}
+		else {
+			justSim();
+		}
+	}
+	else {
+		for ( size_t k = 0; k < counts.size(); ++k ) {
+			_flat.simulate( simWord(k), &_pool );
+		}
+		syncSimPIs();
+		if ( !_simmed ) {
+			initFECs();
+			_simmed = true;
+			updateFECs( vector<const SimWord*>( vals.begin() + 1, vals.end() ) );
+		}
+		else {
+			updateFECs( vals );
+		}
+	}
+	if ( _simWordsUsed < counts.size() ) {
+		_simWordsUsed = counts.size();
+	}
+
+	printFEC();
+	cout << '\r' ;
+	for ( size_t k = 0; k < counts.size(); ++k ) {
+		printSimLog( counts[k], vals[k] );
+	}
+}
+
+void
+CirMgr::initPIs( vector<SimWord>& inputs )
 {
 	assert( inputs.size() == _piNum );
 	for ( size_t i = 0; i < _piNum; ++i ) {
-		_PIs[i].initSim( inputs[i] );
+		_simValues[ _flat.piNode(i) ] = inputs[i];
 	}
 }
 /*
@@ -249,66 +690,50 @@ CirMgr::initFECs()
 bool
 CirMgr::initFECs()
 {
-	//assert( _fecGrps.empty() ); //debug
-	_fecGrps.clear();
-
-	IdList* grp;
-	Hash< FirstSimKey, IdList* > grpHash;
-	vector< IdList* > newGrps;
+	unsigned node;
 	unsigned leadId;
 	unsigned id;
-	unsigned simR;
-	size_t newSize;
 	bool fecInv;
-	bool distinguished = false;
 
-	CirGate::setGlobalRef();
-	for ( size_t i = 0; i < _DFSList.size(); ++i ) {
-		_DFSList[i]->setToGlobalRef();
+	// the phase of a gate is set by its first pattern, as in FirstSimKey
+	if ( _fecEngine == FEC_HASH ) {
+		prepareHash( firstHash, _DFSList.size() );
+	}
+	else {
+		clearScratch();
+		fecMembers.clear();
+		fecLits.clear();
 	}
-
-	grpHash.init( _DFSList.size() / 5 );
 	for ( size_t i = 0; i < _AllList.size(); ++i ) {
+		node = _flat.node( i );
 		if ( i != 0 && 
-			 (!_AllList[i] || 
-			  ! ( _AllList[i]->isGlobalRef() )  || 
-			  _AllList[i]->getTypeStr() != AigGate::typeName() ) ) {
+		     ( node < _flat.andBegin() || node >= _flat.poBegin() ) ) {
 			continue;
 		}
 		_AllList[i]->clearFec();
-		simR = _AllList[i]->getSimResult();
-		if ( !grpHash.check( FirstSimKey(simR), grp ) ) {
-			grp = new IdList;
-			grpHash.forceInsert( simR, grp );
-		}
-		grp->push_back( i );
-	}
-
-	Hash< FirstSimKey, IdList* >::iterator it;
-
-	newSize = 0;
-	for ( it = grpHash.begin(); it != grpHash.end(); ++it ) {
-		grp = (*it).second;
-		if ( grp->size() > 1 ) {
-			newGrps.push_back( grp );
-			++newSize;
+		if ( _fecEngine == FEC_HASH ) {
+			addMember( firstHash, FirstSimKey( _simValues[node] ), i );
 		}
 		else {
-			delete grp;
+			fecMembers.push_back( i );
+			fecLits.push_back( 2 * node + 
+			                   ( _simValues[node].bit(0)? 1: 0 ) );
 		}
 	}
-	if ( newSize != 1 ) {
-		distinguished = true;
+	if ( _fecEngine != FEC_HASH ) {
+		addGroupBySort( vector<const SimWord*>( 1, &_simValues[0] ) );
 	}
+	bool distinguished = ( keptGroups( 0 ) != 1 );
+	buildGroups( _fecGrps );
+	_simWordsUsed = 1;
 
-	swap( _fecGrps, newGrps );
-	for ( size_t i = 0; i < _fecGrps.size(); ++i ){
-		leadId = _fecGrps[i]->front();
-		for ( size_t j = 0; j < _fecGrps[i]->size(); ++j ){
-			id =  (*_fecGrps[i])[j];
-			fecInv = ( _AllList[id]->getSimResult() != 
-					  _AllList[leadId]->getSimResult() );
-			_AllList[id]->setFecGrpId( i );
+	for ( unsigned g = 0; g < _fecGrps.size(); ++g ){
+		leadId = _fecGrps.id( g, 0 );
+		for ( unsigned j = 0; j < _fecGrps.grpSize(g); ++j ){
+			id = _fecGrps.id( g, j );
+			fecInv = ( _simValues[ _flat.node(id) ] != 
+			           _simValues[ _flat.node(leadId) ] );
+			_AllList[id]->setFecGrpId( g );
 			_AllList[id]->setFecInv( fecInv );
 		}
 	}
@@ -319,96 +744,279 @@ void
 CirMgr::firstSim()
 {
 	assert(!_simmed);
-	for ( size_t i = 0; i < _DFSList.size(); ++i ) {
-		_DFSList[i]->simulate();
-	}
+	_flat.simulate( &_simValues[0], &_pool );
+	syncSimPIs();
 	initFECs();
 	_simmed = true;
 }
 
+// Resimulates from the PI words in _simValues.  If the other values still
+// come from the PI words of the last simulation, only the gates a changed
+// PI reaches are simulated again; when most PIs changed, or the values
+// are out of step, the whole AIG is.
 bool
 CirMgr::justSim()
 {
-	for ( size_t i = 0; i < _DFSList.size(); ++i ) {
-		_DFSList[i]->simulate();
+	IdList changed;
+	if ( _simSynced ) {
+		for ( unsigned i = 0; i < _piNum; ++i ) {
+			if ( _simValues[ _flat.piNode(i) ] != _simPIs[i] ) {
+				changed.push_back( _flat.piNode(i) );
+			}
+		}
+	}
+	if ( !_simSynced || 2 * changed.size() > _piNum ) {
+		_flat.simulate( &_simValues[0], &_pool );
+		syncSimPIs();
+		return updateFECs( vector<const SimWord*>( 1, &_simValues[0] ) );
 	}
-	return updateFECs();
+	return simEvents( changed );
 }
 
+// Event-driven simulation from the changed nodes "srcs": a node is
+// simulated once all its changed fanins are (the smallest node first),
+// and its fanouts are scheduled only if its value changed.  Only the FEC
+// groups with a changed gate are refined.
 bool
-CirMgr::updateFECs()
+CirMgr::simEvents( const IdList& srcs )
 {
-	IdList* grp;
-	Hash< SimKey, IdList* > grpHash;
-	vector< IdList* > newGrps;
-	newGrps.reserve( _fecGrps.size() );
-	unsigned id;
-	unsigned simEqv;
-	size_t newSize;
+	priority_queue< unsigned, vector<unsigned>, greater<unsigned> > events;
+	vector<bool> grpMarked( _fecGrps.size(), false );
+	IdList grps;
+	unsigned f;
+	CirGate::setGlobalRef();
+	for ( size_t i = 0; i < srcs.size(); ++i ) {
+		for ( unsigned j = 0; j < _flat.fanoutNum( srcs[i] ); ++j ) {
+			unsigned fo = _flat.fanout( srcs[i], j );
+			CirGate* g = _AllList[ _flat.gateId( fo ) ];
+			if ( !g->isGlobalRef() ) {
+				g->setToGlobalRef();
+				events.push( fo );
+			}
+		}
+	}
+	while ( !events.empty() ) {
+		unsigned n = events.top();
+		events.pop();
+		SimWord old = _simValues[n];
+		_flat.simulate( &_simValues[0], n, n + 1 );
+		if ( _simValues[n] == old ) {
+			continue;
+		}
+		if ( n < _flat.poBegin() &&
+		     _AllList[ _flat.gateId(n) ]->checkFec( f ) && !grpMarked[f] ) {
+			grpMarked[f] = true;
+			grps.push_back( f );
+		}
+		for ( unsigned j = 0; j < _flat.fanoutNum( n ); ++j ) {
+			unsigned fo = _flat.fanout( n, j );
+			CirGate* g = _AllList[ _flat.gateId( fo ) ];
+			if ( !g->isGlobalRef() ) {
+				g->setToGlobalRef();
+				events.push( fo );
+			}
+		}
+	}
+	syncSimPIs();
+	return refineFECs( &_simValues[0], grps );
+}
+
+// Remembers the PI words the values in _simValues are simulated from
+void
+CirMgr::syncSimPIs()
+{
+	_simPIs.resize( _piNum );
+	for ( unsigned i = 0; i < _piNum; ++i ) {
+		_simPIs[i] = _simValues[ _flat.piNode(i) ];
+	}
+	_simSynced = true;
+}
+
+void
+CirMgr::simBatches( vector<SimBatchTask>& tasks )
+{
+	for ( size_t i = 0; i < tasks.size(); ++i ) {
+		_pool.push( &tasks[i] );
+	}
+	_pool.wait();
+}
+
+// Refines every FEC group by the signatures over all the batches at once
+bool
+CirMgr::updateFECs( const vector<const SimWord*>& vals )
+{
+	size_t total = 0;
 	bool distinguished = false;
-	for ( size_t i = 0; i < _fecGrps.size(); ++i ) {
-		grpHash.init( _fecGrps[i]->size() / 5 );
-		for ( size_t j = 0; j < _fecGrps[i]->size(); ++j ) {
-			id = (*(_fecGrps[i]))[j];
+	for ( unsigned g = 0; g < _fecGrps.size(); ++g ) {
+		total += _fecGrps.grpSize(g);
+	}
+	if ( _fecEngine == FEC_HASH ) {
+		prepareHash( fecHash, total );
+	}
+	else {
+		clearScratch();
+	}
+	for ( unsigned g = 0; g < _fecGrps.size(); ++g ) {
+		unsigned first = fecCount.size();
+		partitionFecGrp( vals, g );
+		if ( keptGroups( first ) != 1 ) {
+			distinguished = true;
+		}
+	}
+	buildGroups( _fecGrps );
+	for ( unsigned g = 0; g < _fecGrps.size(); ++g ){
+		for ( unsigned j = 0; j < _fecGrps.grpSize(g); ++j ){
+			_AllList[ _fecGrps.id( g, j ) ]->setFecGrpId( g );
+		}
+	}
+	return distinguished;
+}
+
+// Takes the members of group "g" out of their group and counts them into
+// the new groups of the refinement scratch, by the chosen engine
+void
+CirMgr::partitionFecGrp( const vector<const SimWord*>& vals, unsigned g )
+{
+	unsigned id;
+	if ( _fecEngine == FEC_HASH ) {
+		for ( unsigned j = 0; j < _fecGrps.grpSize(g); ++j ) {
+			id = _fecGrps.id( g, j );
 			_AllList[id]->clearFec();
-			simEqv = _AllList[id]->getSimEqv();
-			if ( !grpHash.check( SimKey(simEqv), grp ) ) {
-				grp = new IdList;
-				grpHash.forceInsert( simEqv, grp );
-			}
-			grp->push_back( id );
+			addMember( fecHash, SimKey( vals, _flat.node(id),
+			           _AllList[id]->isFecInv(), g ), id );
 		}
-		delete _fecGrps[i];
-		_fecGrps[i] = 0;
+		return;
+	}
+	fecMembers.clear();
+	fecLits.clear();
+	for ( unsigned j = 0; j < _fecGrps.grpSize(g); ++j ) {
+		id = _fecGrps.id( g, j );
+		fecMembers.push_back( id );
+		fecLits.push_back( 2 * _flat.node(id) + 
+		                   ( _AllList[id]->isFecInv()? 1: 0 ) );
+		_AllList[id]->clearFec();
+	}
+	addGroupBySort( vals );
+}
 
-		Hash< SimKey, IdList* >::iterator it;
+// Writes the buffered counterexamples over the PI words of pattern 0 and
+// resimulates.  A model sets only the PIs in the fanin cones of the pair
+// it came from (see addCex()), so few PI words change and justSim()
+// takes the event-driven path: only the logic they reach is simulated,
+// and only the groups of the changed gates are refined.
+bool
+CirMgr::flushCexs()
+{
+	if ( _cexBuf.empty() ) {
+		return false;
+	}
+	vector<SimWord> pis( _piNum );
+	for ( unsigned i = 0; i < _piNum; ++i ) {
+		pis[i] = _simValues[ _flat.piNode(i) ];
+	}
+	_cexBuf.flush( pis );
+	for ( unsigned i = 0; i < _piNum; ++i ) {
+		_simValues[ _flat.piNode(i) ] = pis[i];
+	}
+	return justSim();
+}
 
-		newSize = 0;
-		for ( it = grpHash.begin(); it != grpHash.end(); ++it ) {
-			grp = (*it).second;
-			if ( grp->size() > 1 ) {
-				newGrps.push_back( grp );
-				++newSize;
+// Like updateFECs(), for the groups "grps" only, and in place: each one
+// is split inside its own range of the arena.  A group with nothing left
+// takes the last group.
+bool
+CirMgr::refineFECs( const SimWord* val, const IdList& grps )
+{
+	vector<const SimWord*> vals( 1, val );
+	size_t total = 0;
+	bool distinguished = false;
+	for ( size_t i = 0; i < grps.size(); ++i ) {
+		total += _fecGrps.grpSize( grps[i] );
+	}
+	if ( _fecEngine == FEC_HASH ) {
+		prepareHash( fecHash, total );
+	}
+	else {
+		clearScratch();
+	}
+
+	IdList holes;
+	size_t m = 0;
+	for ( size_t i = 0; i < grps.size(); ++i ) {
+		unsigned g = grps[i];
+		unsigned first = fecCount.size();
+		partitionFecGrp( vals, g );
+		unsigned last = fecCount.size();
+
+		// new groups of 2 or more to the front of the range, by key
+		IdList& sizes = fecFill;
+		sizes.clear();
+		unsigned pos = 0;
+		for ( unsigned k = first; k < last; ++k ) {
+			if ( fecCount[k] > 1 ) {
+				sizes.push_back( fecCount[k] );
+				unsigned n = fecCount[k];
+				fecCount[k] = pos;
+				pos += n;
 			}
 			else {
-				delete grp;
+				fecCount[k] = UINT_MAX;
 			}
 		}
-		if ( newSize != 1 ) {
+		for ( unsigned j = 0; j < _fecGrps.grpSize(g); ++j, ++m ) {
+			unsigned k = fecSlot[m];
+			if ( fecCount[k] != UINT_MAX ) {
+				_fecGrps.id( g, fecCount[k]++ ) = fecIds[m];
+			}
+		}
+		if ( sizes.size() != 1 ) {
 			distinguished = true;
 		}
+		unsigned before = _fecGrps.size();
+		_fecGrps.split( g, sizes.empty()? 0: &sizes[0], sizes.size() );
+		if ( sizes.empty() ) {
+			holes.push_back( g );
+		}
+		for ( unsigned j = 0; j < _fecGrps.grpSize(g); ++j ) {
+			_AllList[ _fecGrps.id( g, j ) ]->setFecGrpId( g );
+		}
+		for ( unsigned ng = before; ng < _fecGrps.size(); ++ng ) {
+			for ( unsigned j = 0; j < _fecGrps.grpSize(ng); ++j ) {
+				_AllList[ _fecGrps.id( ng, j ) ]->setFecGrpId( ng );
+			}
+		}
 	}
-	swap( _fecGrps, newGrps );
-	for ( size_t i = 0; i < _fecGrps.size(); ++i ){
-		for ( size_t j = 0; j < _fecGrps[i]->size(); ++j ){
-			_AllList[ (*_fecGrps[i])[j] ]->
-				setFecGrpId( i );
+
+	// the largest hole first, so the last group is never an earlier hole
+	sort( holes.begin(), holes.end() );
+	while ( !holes.empty() ) {
+		unsigned f = holes.back();
+		holes.pop_back();
+		_fecGrps.eraseGrp( f );
+		if ( f < _fecGrps.size() ) {
+			for ( unsigned j = 0; j < _fecGrps.grpSize(f); ++j ) {
+				_AllList[ _fecGrps.id( f, j ) ]->setFecGrpId( f );
+			}
 		}
 	}
 	return distinguished;
 }
 
+// The log and the packed patterns are written by their own threads
 void
-CirMgr::printSimLog( unsigned til )
+CirMgr::printSimLog( unsigned til, const SimWord* val )
 {
-	if ( !_simLog ) {
-		return;
+	if ( !val ) {
+		val = &_simValues[0];
 	}
-	unsigned mask = 1;
-	if ( til > 8 * sizeof(unsigned) ) {
-		til = 8 * sizeof(unsigned);
+	if ( til > SimWord::BITS ) {
+		til = SimWord::BITS;
 	}
-	for ( size_t i = 0; i < til; ++i ) {
-		for ( size_t j = 0; j < _piNum; ++j ){
-			*_simLog << ( ( mask & _PIs[j].getSimResult() ) ?
-			1 : 0 ) ;
-		}
-			*_simLog << " " ;
-		for ( size_t j = 0; j < _poNum; ++j ) {
-			*_simLog << ( ( mask & _POs[j].getSimResult() ) ? 1 : 0 );
-		}
-		*_simLog << endl;
-		mask = mask << 1;
+	if ( _simPack ) {
+		_simPack->write( val + _flat.piNode(0), 0, til );
+	}
+	if ( _simLog ) {
+		_simLog->write( val + _flat.piNode(0), val + _flat.poNode(0), til );
 	}
 }
 
@@ -436,7 +1044,10 @@ CirMgr::maxFail()
 			max = 5;
 		}
 	}
-	return max; 
+	// "max" counts rounds of 32 patterns; a round now carries 
+	// SimWord::BITS patterns
+	max = ( max * 32 + SimWord::BITS - 1 ) / SimWord::BITS;
+	return ( max < 2 )? 2: max; 
 }
 /*
 void
@@ -470,10 +1081,10 @@ CirMgr::debugSim()
 		if ( count == 0 ) { break; }
 
 		for ( size_t i = 0; i < _piNum; ++i ) {
-			input = 0;
+			input.reset();
 			for ( size_t j = 0; j < count; ++j ) {
 				if ( patterns[j][i] == '1' ) {
-					input += 1 << j;
+					input.setBit( j, 1 );
 				}
 			}
 			_PIs[i].initSim( input );
@@ -0,0 +1,160 @@
+/****************************************************************************
+  FileName     [ cirSimWord.h ]
+  PackageName  [ cir ]
+  Synopsis     [ Define the bit-parallel simulation word ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2008-2013 LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#ifndef CIR_SIM_WORD_H
+#define CIR_SIM_WORD_H
+
+#include <cstddef>
+#include <climits>
+#include "util.h"
+
+// Number of patterns carried by one simulation word: 64, 256 or 512.
+// Set it through PKGFLAG in src/cir/Makefile.  The 256/512-bit words use
+// AVX2/AVX-512 when the compiler targets them (-mavx2, -mavx512f);
+// otherwise they fall back to plain 64-bit loops.
+#ifndef SIM_WORD_BITS
+#define SIM_WORD_BITS 64
+#endif
+
+#if SIM_WORD_BITS != 64 && SIM_WORD_BITS != 256 && SIM_WORD_BITS != 512
+#error "SIM_WORD_BITS must be 64, 256 or 512"
+#endif
+
+#if SIM_WORD_BITS == 512 && defined(__AVX512F__)
+#define SIM_USE_AVX512
+#include <immintrin.h>
+#elif SIM_WORD_BITS >= 256 && defined(__AVX2__)
+#define SIM_USE_AVX2
+#include <immintrin.h>
+#endif
+
+typedef unsigned long long SimChunk;
+
+class SimWord
+{
+public:
+   static const unsigned BITS = SIM_WORD_BITS;
+   static const unsigned CHUNK_BITS = 8 * sizeof(SimChunk);
+   static const unsigned CHUNKS = BITS / CHUNK_BITS;
+
+   SimWord() { reset(); }
+
+   void reset() {
+      for ( unsigned i = 0; i < CHUNKS; ++i ) { _c[i] = 0; }
+   }
+   void random() {
+      for ( unsigned i = 0; i < CHUNKS; ++i ) {
+         _c[i] = ( SimChunk( rnGen(INT_MAX) ) << 33 ) ^
+                 ( SimChunk( rnGen(INT_MAX) ) << 11 ) ^
+                   SimChunk( rnGen(INT_MAX) );
+      }
+   }
+
+   void random( LocalRandomNumGen& g ) {
+      for ( unsigned i = 0; i < CHUNKS; ++i ) { _c[i] = g.next(); }
+   }
+
+   bool bit( unsigned b ) const {
+      return ( _c[ b / CHUNK_BITS ] >> ( b % CHUNK_BITS ) ) & 1;
+   }
+   void setBit( unsigned b, bool v ) {
+      SimChunk mask = SimChunk(1) << ( b % CHUNK_BITS );
+      if ( v ) { _c[ b / CHUNK_BITS ] |= mask; }
+      else { _c[ b / CHUNK_BITS ] &= ~mask; }
+   }
+   SimChunk chunk( unsigned i ) const { return _c[i]; }
+   void setChunk( unsigned i, SimChunk c ) { _c[i] = c; }
+
+   // all-zero or all-one word, handy to flip a word branch-free by "^"
+   static SimWord mask( bool ones ) {
+      SimWord w;
+      for ( unsigned i = 0; i < CHUNKS; ++i ) { w._c[i] = -SimChunk(ones); }
+      return w;
+   }
+
+   SimWord operator & ( const SimWord& w ) const {
+      SimWord r;
+#if defined(SIM_USE_AVX512)
+      _mm512_storeu_si512( r._c, _mm512_and_si512(
+         _mm512_loadu_si512( _c ), _mm512_loadu_si512( w._c ) ) );
+#elif defined(SIM_USE_AVX2)
+      for ( unsigned i = 0; i < CHUNKS; i += 4 ) {
+         _mm256_storeu_si256( (__m256i*)( r._c + i ), _mm256_and_si256(
+            _mm256_loadu_si256( (const __m256i*)( _c + i ) ),
+            _mm256_loadu_si256( (const __m256i*)( w._c + i ) ) ) );
+      }
+#else
+      for ( unsigned i = 0; i < CHUNKS; ++i ) { r._c[i] = _c[i] & w._c[i]; }
+#endif
+      return r;
+   }
+   SimWord operator ^ ( const SimWord& w ) const {
+      SimWord r;
+#if defined(SIM_USE_AVX512)
+      _mm512_storeu_si512( r._c, _mm512_xor_si512(
+         _mm512_loadu_si512( _c ), _mm512_loadu_si512( w._c ) ) );
+#elif defined(SIM_USE_AVX2)
+      for ( unsigned i = 0; i < CHUNKS; i += 4 ) {
+         _mm256_storeu_si256( (__m256i*)( r._c + i ), _mm256_xor_si256(
+            _mm256_loadu_si256( (const __m256i*)( _c + i ) ),
+            _mm256_loadu_si256( (const __m256i*)( w._c + i ) ) ) );
+      }
+#else
+      for ( unsigned i = 0; i < CHUNKS; ++i ) { r._c[i] = _c[i] ^ w._c[i]; }
+#endif
+      return r;
+   }
+   SimWord operator ~ () const { return *this ^ mask( true ); }
+
+   bool operator == ( const SimWord& w ) const {
+#if defined(SIM_USE_AVX512)
+      return _mm512_cmpneq_epi64_mask( _mm512_loadu_si512( _c ),
+                                       _mm512_loadu_si512( w._c ) ) == 0;
+#elif defined(SIM_USE_AVX2)
+      for ( unsigned i = 0; i < CHUNKS; i += 4 ) {
+         __m256i x = _mm256_xor_si256(
+            _mm256_loadu_si256( (const __m256i*)( _c + i ) ),
+            _mm256_loadu_si256( (const __m256i*)( w._c + i ) ) );
+         if ( !_mm256_testz_si256( x, x ) ) { return false; }
+      }
+      return true;
+#else
+      for ( unsigned i = 0; i < CHUNKS; ++i ) {
+         if ( _c[i] != w._c[i] ) { return false; }
+      }
+      return true;
+#endif
+   }
+   bool operator != ( const SimWord& w ) const { return !( *this == w ); }
+
+   // Mixes every chunk; the buckets of the FEC hashes are taken modulo a
+   // small prime, so the low bits must depend on the whole word.
+   size_t hash() const {
+      SimChunk h = 0;
+      for ( unsigned i = 0; i < CHUNKS; ++i ) {
+         h ^= _c[i] + 0x9e3779b97f4a7c15ULL + ( h << 6 ) + ( h >> 2 );
+      }
+      return size_t( mix( h ) );
+   }
+
+   // The fmix64 finalizer: a bijection, and every output bit depends on
+   // every input bit
+   static SimChunk mix( SimChunk h ) {
+      h ^= h >> 33;
+      h *= 0xff51afd7ed558ccdULL;
+      h ^= h >> 33;
+      h *= 0xc4ceb9fe1a85ec53ULL;
+      h ^= h >> 33;
+      return h;
+   }
+
+private:
+   SimChunk _c[CHUNKS];
+};
+
+#endif // CIR_SIM_WORD_H
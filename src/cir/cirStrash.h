@@ -0,0 +1,39 @@
+/****************************************************************************
+  FileName     [ cirStrash.h ]
+  PackageName  [ cir ]
+  Synopsis     [ Define the key of the structural hash table ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2008-2013 LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#ifndef CIR_STRASH_H
+#define CIR_STRASH_H
+
+#include <cstddef>
+
+// The two fanin literals (2 * id + inverted) of an AIG, the smaller one
+// first, so that the order of the fanins does not matter
+class StrashKey
+{
+public:
+   StrashKey( unsigned a, unsigned b ) {
+      if ( a < b ) { _lit0 = a; _lit1 = b; }
+      else { _lit0 = b; _lit1 = a; }
+   }
+
+   size_t operator () () const {
+      size_t k = ( size_t( _lit0 ) << 32 ) ^ _lit1;
+      k ^= k >> 33;
+      k *= 0xff51afd7ed558ccdULL;
+      return k ^ ( k >> 33 );
+   }
+   bool operator == ( const StrashKey& k ) const {
+      return _lit0 == k._lit0 && _lit1 == k._lit1;
+   }
+
+private:
+   unsigned _lit0;
+   unsigned _lit1;
+};
+
+#endif // CIR_STRASH_H
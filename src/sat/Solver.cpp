@@ -26,11 +26,11 @@ OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWA
 // Helper functions:
 
 
-void removeWatch(vec<Clause*>& ws, Clause* elem)
+void removeWatch(vec<Watcher>& ws, CRef elem)
 {
     if (ws.size() == 0) return;     // (skip lists that are already cleared)
     int j = 0;
-    for (; ws[j] != elem  ; j++) assert(j < ws.size());
+    for (; ws[j].cref != elem; j++) assert(j < ws.size());
     for (; j < ws.size()-1; j++) ws[j] = ws[j+1];
     ws.pop();
 }
@@ -55,18 +55,19 @@ void removeWatch(vec<Clause*>& ws, Clause* elem)
 |             literal. One of the watches will always be on this literal, the other will be set to
 |             the literal with the highest decision level.
 |    id     - If logging proof, learnt clauses should be given an ID by caller.
+|    lbd    - The LBD of a learnt clause, see 'computeLBD()'.
 |  
 |  Effect:
 |    Activity heuristics are updated.
 |________________________________________________________________________________________________@*/
-void Solver::newClause(const vec<Lit>& ps_, bool learnt, ClauseId id , bool A)
+void Solver::newClause(const vec<Lit>& ps_, bool learnt, ClauseId id , bool A, uint lbd)
 {
     assert(learnt || id == ClauseId_NULL);
     if (!ok) return;
 
     vec<Lit>    qs;
     if (!learnt){
-        assert(decisionLevel() == 0);
+        cancelUntil(0);                     // (drops the assumptions left by 'keep_assumps')
         ps_.copyTo(qs);                     // Make a copy of the input vector.
 
         // Remove duplicates:
@@ -105,7 +106,8 @@ void Solver::newClause(const vec<Lit>& ps_, bool learnt, ClauseId id , bool A)
 
     }else{
         // Allocate clause:
-        Clause* c   = Clause_new(learnt, ps, id);
+        CRef    cr  = ca.alloc(learnt, ps, id);
+        Clause& c   = ca[cr];
 
         if (learnt){
             // Put the second watch on the literal with highest decision level:
@@ -115,47 +117,91 @@ void Solver::newClause(const vec<Lit>& ps_, bool learnt, ClauseId id , bool A)
                 if (level[var(ps[i])] > max)
                     max   = level[var(ps[i])],
                     max_i = i;
-            (*c)[1]     = ps[max_i];
-            (*c)[max_i] = ps[1];
+            c[1]     = ps[max_i];
+            c[max_i] = ps[1];
 
             // Bumping:
             claBumpActivity(c); // (newly learnt clauses should be considered active)
+            c.lbd() = lbd;
 
             // Enqueue asserting literal:
-            check(enqueue((*c)[0], c));
+            check(enqueue(c[0], cr));
 
             // Store clause:
-            watches[index(~(*c)[0])].push(c);
-            watches[index(~(*c)[1])].push(c);
-            learnts.push(c);
-            stats.learnts_literals += c->size();
+            vec<vec<Watcher> >& ws = c.size() == 2 ? watchesBin : watches;
+            ws[index(~c[0])].push(Watcher(cr, c[1]));
+            ws[index(~c[1])].push(Watcher(cr, c[0]));
+            learnts.push(cr);
+            stats.learnts_literals += c.size();
 
         }else{
             // Store clause:
-            watches[index(~(*c)[0])].push(c);
-            watches[index(~(*c)[1])].push(c);
-            clauses.push(c);
-            stats.clauses_literals += c->size();
+            vec<vec<Watcher> >& ws = c.size() == 2 ? watchesBin : watches;
+            ws[index(~c[0])].push(Watcher(cr, c[1]));
+            ws[index(~c[1])].push(Watcher(cr, c[0]));
+            clauses.push(cr);
+            stats.clauses_literals += c.size();
         }
     }
 }
 
 
-// Disposes a clauses and removes it from watcher lists. NOTE! Low-level; does NOT change the 'clauses' and 'learnts' vector.
+// Adds a problem clause that is meant to be retired later. Typically 'ps' contains '~g' for some
+// activation variable 'g' that is only ever assumed TRUE; 'removeGuard(g)' then drops the clause.
 //
-void Solver::remove(Clause* c, bool just_dealloc)
+void Solver::addGuardedClause(const vec<Lit>& ps)
 {
-    if (!just_dealloc){
-        removeWatch(watches[index(~(*c)[0])], c),
-        removeWatch(watches[index(~(*c)[1])], c);
+    int n = clauses.size();
+    newClause(ps);
+    if (clauses.size() > n){
+        guarded.push(clauses.last());
+        clauses.pop(); }
+}
 
-        if (c->learnt()) stats.learnts_literals -= c->size();
-        else             stats.clauses_literals -= c->size();
 
-        if (proof != NULL) proof->deleted(c->id());
+// Removes every guarded clause containing variable 'g' and, if 'learnts_too', every learnt clause
+// containing it. Learnt clauses derived from a guarded clause always contain 'g' (unless 'g' was
+// assigned at top-level), so no consequence of the retired clauses survives. Only legal between
+// calls to 'solve()'; drops the assumptions left by 'keep_assumps'.
+//
+void Solver::removeGuard(Var g, bool learnts_too)
+{
+    cancelUntil(0);
+    for (int type = 0; type < (learnts_too ? 2 : 1); type++){
+        vec<CRef>&    cs = type ? learnts : guarded;
+        int           j  = 0;
+        for (int i = 0; i < cs.size(); i++){
+            Clause& c   = ca[cs[i]];
+            bool    has = false;
+            for (int k = 0; k < c.size() && !has; k++)
+                has = (var(c[k]) == g);
+            if (has && !locked(cs[i]))
+                remove(cs[i]);
+            else
+                cs[j++] = cs[i];
+        }
+        cs.shrink(cs.size()-j);
     }
+    checkGarbage();
+}
 
-    xfree(c);
+
+// Disposes a clauses and removes it from watcher lists. NOTE! Low-level; does NOT change the 'clauses' and 'learnts' vector.
+// The clause's words stay in 'ca' (as waste) until the next 'garbageCollect()'.
+//
+void Solver::remove(CRef cr)
+{
+    const Clause&       c  = ca[cr];
+    vec<vec<Watcher> >& ws = c.size() == 2 ? watchesBin : watches;
+    removeWatch(ws[index(~c[0])], cr),
+    removeWatch(ws[index(~c[1])], cr);
+
+    if (c.learnt()) stats.learnts_literals -= c.size();
+    else            stats.clauses_literals -= c.size();
+
+    if (proof != NULL) proof->deleted(c.id());
+
+    ca.free(cr);
 }
 
 
@@ -163,11 +209,12 @@ void Solver::remove(Clause* c, bool just_dealloc)
 // the clause is binary and satisfied, in which case the first literal is true)
 // Returns True if clause is satisfied (will be removed), False otherwise.
 //
-bool Solver::simplify(Clause* c) const
+bool Solver::simplify(CRef cr) const
 {
     assert(decisionLevel() == 0);
-    for (int i = 0; i < c->size(); i++){
-        if (value((*c)[i]) == l_True)
+    const Clause& c = ca[cr];
+    for (int i = 0; i < c.size(); i++){
+        if (value(c[i]) == l_True)
             return true;
     }
     return false;
@@ -186,17 +233,29 @@ Var Solver::newVar() {
     index = nVars();
     watches     .push();          // (list for positive literal)
     watches     .push();          // (list for negative literal)
-    reason      .push(NULL);
+    watchesBin  .push();
+    watchesBin  .push();
+    reason      .push(CRef_Undef);
     assigns     .push(toInt(l_Undef));
     level       .push(-1);
     trail_pos   .push(-1);
     activity    .push(0);
+    polarity    .push(1);
     order       .newVar();
     analyze_seen.push(0);
     if (proof != NULL) unit_id.push(ClauseId_NULL);
     return index; }
 
 
+// Sets the activity as if 'v' had been bumped 'act' times just now.
+void Solver::setActivity(Var v, double act) {
+    bool    up  = act * var_inc > activity[v];
+    activity[v] = act * var_inc;
+    if (up) order.update(v);
+    else    order.lower(v);
+    if (activity[v] > 1e100) varRescaleActivity(); }
+
+
 // Returns FALSE if immediate conflict.
 bool Solver::assume(Lit p) {
     trail_lim.push(trail.size());
@@ -209,7 +268,8 @@ void Solver::cancelUntil(int level) {
         for (int c = trail.size()-1; c >= trail_lim[level]; c--){
             Var     x  = var(trail[c]);
             assigns[x] = toInt(l_Undef);
-            reason [x] = NULL;
+            reason [x] = CRef_Undef;
+            if (phase_saving) polarity[x] = (char)sign(trail[c]);
             order.undo(x); }
         trail.shrink(trail.size() - trail_lim[level]);
         trail_lim.shrink(trail_lim.size() - level);
@@ -222,7 +282,7 @@ void Solver::cancelUntil(int level) {
 
 /*_________________________________________________________________________________________________
 |
-|  analyze : (confl : Clause*) (out_learnt : vec<Lit>&) (out_btlevel : int&)  ->  [void]
+|  analyze : (confl : CRef) (out_learnt : vec<Lit>&) (out_btlevel : int&)  ->  [void]
 |  
 |  Description:
 |    Analyze conflict and produce a reason clause ('out_learnt') and a backtracking level
@@ -243,7 +303,7 @@ public:
     lastToFirst_lt(const vec<int>& t) : trail_pos(t) {}
     bool operator () (Lit p, Lit q) { return trail_pos[var(p)] > trail_pos[var(q)]; }
 };
-void Solver::analyze(Clause* confl, vec<Lit>& out_learnt, int& out_btlevel)
+void Solver::analyze(CRef confl, vec<Lit>& out_learnt, int& out_btlevel)
 {
     vec<char>&     seen  = analyze_seen;
     int            pathC = 0;
@@ -251,16 +311,22 @@ void Solver::analyze(Clause* confl, vec<Lit>& out_learnt, int& out_btlevel)
 
     // Generate conflict clause:
     //
-    if (proof != NULL) proof->beginChain(confl->id());
+    if (proof != NULL) proof->beginChain(ca[confl].id());
     out_learnt.push();          // (leave room for the asserting literal)
     out_btlevel = 0;
     int index = trail.size()-1;
     for(;;){
-        assert(confl != NULL);  // (otherwise should be UIP)
-
-        Clause& c = *confl;
-        if (c.learnt())
-            claBumpActivity(&c);
+        assert(confl != CRef_Undef);    // (otherwise should be UIP)
+
+        Clause& c = ca[confl];
+        if (c.learnt()){
+            claBumpActivity(c);
+            if (lbd_update && c.lbd() > 2){
+                uint lbd = computeLBD(&c[0], c.size());
+                if (lbd + 1 < c.lbd())
+                    c.lbd() = lbd;
+            }
+        }
 
         for (int j = (p == lit_Undef) ? 0 : 1; j < c.size(); j++){
             Lit q = c[j];
@@ -287,7 +353,7 @@ void Solver::analyze(Clause* confl, vec<Lit>& out_learnt, int& out_btlevel)
         pathC--;
         if (pathC == 0) break;
 
-        if (proof != NULL) proof->resolve(confl->id(), ~p);
+        if (proof != NULL) proof->resolve(ca[confl].id(), ~p);
     }
     out_learnt[0] = ~p;
 
@@ -303,18 +369,18 @@ void Solver::analyze(Clause* confl, vec<Lit>& out_learnt, int& out_btlevel)
 
         analyze_toclear.clear();
         for (i = j = 1; i < out_learnt.size(); i++)
-            if (reason[var(out_learnt[i])] == NULL || !analyze_removable(out_learnt[i], min_level))
+            if (reason[var(out_learnt[i])] == CRef_Undef || !analyze_removable(out_learnt[i], min_level))
                 out_learnt[j++] = out_learnt[i];
     }else if(expensive_ccmin == 1){
         // Simplify conflict clause (a little):
         //
         analyze_toclear.clear();
         for (i = j = 1; i < out_learnt.size(); i++){
-            Clause* r = reason[var(out_learnt[i])];
-            if (r == NULL)
+            CRef r = reason[var(out_learnt[i])];
+            if (r == CRef_Undef)
                 out_learnt[j++] = out_learnt[i];
             else{
-                Clause& c = *r;
+                Clause& c = ca[r];
                 for (int k = 1; k < c.size(); k++)
                     if (!seen[var(c[k])] && level[var(c[k])] != 0){
                         out_learnt[j++] = out_learnt[i];
@@ -333,7 +399,7 @@ void Solver::analyze(Clause* confl, vec<Lit>& out_learnt, int& out_btlevel)
         for (int k = 0; k < analyze_toclear.size(); k++){
             Var     v = var(analyze_toclear[k]); assert(level[v] > 0);
 				Lit     l = analyze_toclear[k];
-            Clause& c = *reason[v];
+            Clause& c = ca[reason[v]];
             proof->resolve(c.id(), l);
             for (int k = 1; k < c.size(); k++)
                 if (level[var(c[k])] == 0)
@@ -356,17 +422,17 @@ void Solver::analyze(Clause* confl, vec<Lit>& out_learnt, int& out_btlevel)
 //
 bool Solver::analyze_removable(Lit p, uint min_level)
 {
-    assert(reason[var(p)] != NULL);
+    assert(reason[var(p)] != CRef_Undef);
     analyze_stack.clear(); analyze_stack.push(p);
     int top = analyze_toclear.size();
     while (analyze_stack.size() > 0){
-        assert(reason[var(analyze_stack.last())] != NULL);
-        Clause& c = *reason[var(analyze_stack.last())];
+        assert(reason[var(analyze_stack.last())] != CRef_Undef);
+        Clause& c = ca[reason[var(analyze_stack.last())]];
         analyze_stack.pop();
         for (int i = 1; i < c.size(); i++){
             Lit p = c[i];
             if (!analyze_seen[var(p)] && level[var(p)] != 0){
-                if (reason[var(p)] != NULL && ((1 << (level[var(p)] & 31)) & min_level) != 0){
+                if (reason[var(p)] != CRef_Undef && ((1 << (level[var(p)] & 31)) & min_level) != 0){
                     analyze_seen[var(p)] = 1;
                     analyze_stack.push(p);
                     analyze_toclear.push(p);
@@ -387,7 +453,7 @@ bool Solver::analyze_removable(Lit p, uint min_level)
 
 /*_________________________________________________________________________________________________
 |
-|  analyzeFinal : (confl : Clause*) (skip_first : bool)  ->  [void]
+|  analyzeFinal : (confl : CRef) (skip_first : bool)  ->  [void]
 |  
 |  Description:
 |    Specialized analysis procedure to express the final conflict in terms of assumptions.
@@ -395,7 +461,7 @@ bool Solver::analyze_removable(Lit p, uint min_level)
 |    making assumptions). If 'skip_first' is TRUE, the first literal of 'confl' is  ignored (needed
 |    if conflict arose before search even started).
 |________________________________________________________________________________________________@*/
-void Solver::analyzeFinal(Clause* confl, bool skip_first)
+void Solver::analyzeFinal(CRef cr, bool skip_first)
 {
     // -- NOTE! This code is relatively untested. Please report bugs!
     conflict.clear();
@@ -404,10 +470,11 @@ void Solver::analyzeFinal(Clause* confl, bool skip_first)
         return; }
    //assert(false);
     vec<char>&     seen  = analyze_seen;
-    if (proof != NULL) proof->beginChain(confl->id());
-    for (int i = skip_first ? 1 : 0; i < confl->size(); i++){
-        Var     x = var((*confl)[i]);
-		  Lit		 l = (*confl)[i];
+    Clause&        confl = ca[cr];
+    if (proof != NULL) proof->beginChain(confl.id());
+    for (int i = skip_first ? 1 : 0; i < confl.size(); i++){
+        Var     x = var(confl[i]);
+		  Lit		 l = confl[i];
         if (level[x] > 0)
             seen[x] = 1;
         else
@@ -419,12 +486,12 @@ void Solver::analyzeFinal(Clause* confl, bool skip_first)
         Var     x = var(trail[i]);
 		  Lit     l = trail[i];
         if (seen[x]){
-            Clause* r = reason[x];
-            if (r == NULL){
+            CRef r = reason[x];
+            if (r == CRef_Undef){
                 assert(level[x] > 0);
                 conflict.push(~trail[i]);
             }else{
-                Clause& c = *r;
+                Clause& c = ca[r];
                 if (proof != NULL) proof->resolve(c.id(), l);
                 for (int j = 1; j < c.size(); j++)
                     if (level[var(c[j])] > 0)
@@ -441,7 +508,7 @@ void Solver::analyzeFinal(Clause* confl, bool skip_first)
 
 /*_________________________________________________________________________________________________
 |
-|  enqueue : (p : Lit) (from : Clause*)  ->  [bool]
+|  enqueue : (p : Lit) (from : CRef)  ->  [bool]
 |  
 |  Description:
 |    Puts a new fact on the propagation queue as well as immediately updating the variable's value.
@@ -450,12 +517,12 @@ void Solver::analyzeFinal(Clause* confl, bool skip_first)
 |  Input:
 |    p    - The fact to enqueue
 |    from - [Optional] Fact propagated from this (currently) unit clause. Stored in 'reason[]'.
-|           Default value is NULL (no reason).
+|           Default value is CRef_Undef (no reason).
 |  
 |  Output:
 |    TRUE if fact was enqueued without conflict, FALSE otherwise.
 |________________________________________________________________________________________________@*/
-bool Solver::enqueue(Lit p, Clause* from)
+bool Solver::enqueue(Lit p, CRef from)
 {
     if (value(p) != l_Undef)
         return value(p) != l_False;
@@ -474,71 +541,88 @@ bool Solver::enqueue(Lit p, Clause* from)
 
 /*_________________________________________________________________________________________________
 |
-|  propagate : [void]  ->  [Clause*]
+|  propagate : [void]  ->  [CRef]
 |  
 |  Description:
 |    Propagates all enqueued facts. If a conflict arises, the conflicting clause is returned,
-|    otherwise NULL. NOTE! This method has been optimized for speed rather than readability.
+|    otherwise CRef_Undef. NOTE! This method has been optimized for speed rather than readability.
 |  
 |    Post-conditions:
 |      * The propagation queue is empty, even if there was a conflict.
 |________________________________________________________________________________________________@*/
-Clause* Solver::propagate()
+CRef Solver::propagate()
 {
-    Clause* confl = NULL;
+    CRef    confl = CRef_Undef;
     while (qhead < trail.size()){
         stats.propagations++;
         simpDB_props--;
 
         Lit            p  = trail[qhead++];     // 'p' is enqueued fact to propagate.
-        vec<Clause*>&  ws = watches[index(p)];
-        Clause**       i,** j,** end;
+        Lit            false_lit = ~p;
+
+        // Binary clauses first; the blocker is the literal implied, so the clause itself is only
+        // touched to put that literal first when it becomes a reason (or a conflict):
+        vec<Watcher>&  wbin = watchesBin[index(p)];
+        for (int k = 0; k < wbin.size(); k++){
+            Lit   imp = wbin[k].blocker;
+            lbool val = value(imp);
+            if (val == l_True) continue;
+
+            CRef    cr = wbin[k].cref;
+            Clause& c  = ca[cr];
+            if (c[0] == false_lit)
+                c[0] = c[1], c[1] = false_lit;
+            if (decisionLevel() == 0 && proof != NULL)
+                proofUnit(c);
+            if (!enqueue(imp, cr)){
+                if (decisionLevel() == 0)
+                    ok = false;
+                confl = cr;
+                qhead = trail.size();
+                break; }
+        }
+        if (confl != CRef_Undef) break;
+
+        vec<Watcher>&  ws = watches[index(p)];
+        Watcher        *i, *j, *end;
+
+        for (i = j = (Watcher*)ws, end = i + ws.size();  i != end;){
+            // Satisfied by the blocker? Then the clause need not be looked at.
+            Lit blocker = i->blocker;
+            if (value(blocker) == l_True){
+                *j++ = *i++; continue; }
 
-        for (i = j = (Clause**)ws, end = i + ws.size();  i != end;){
-            Clause& c = **i; i++;
+            CRef    cr = i->cref;
+            Clause& c  = ca[cr];
+            i++;
             // Make sure the false literal is data[1]:
-            Lit false_lit = ~p;
             if (c[0] == false_lit)
                 c[0] = c[1], c[1] = false_lit;
 
             assert(c[1] == false_lit);
 
             // If 0th watch is true, then clause is already satisfied.
-            Lit   first = c[0];
-            lbool val   = value(first);
-            if (val == l_True){
-                *j++ = &c;
+            Lit     first = c[0];
+            Watcher w(cr, first);
+            if (first != blocker && value(first) == l_True){
+                *j++ = w;
             }else{
                 // Look for new watch:
                 for (int k = 2; k < c.size(); k++)
                     if (value(c[k]) != l_False){
                         c[1] = c[k]; c[k] = false_lit;
-                        watches[index(~c[1])].push(&c);
+                        watches[index(~c[1])].push(w);
                         goto FoundWatch; }
 
                 // Did not find watch -- clause is unit under assignment:
-                if (decisionLevel() == 0 && proof != NULL){
-                    // Log the production of this unit clause:
-                    proof->beginChain(c.id());
-                    for (int k = 1; k < c.size(); k++)
-                        proof->resolve(unit_id[var(c[k])], c[k]);
-                    ClauseId id = proof->endChain();
-                    assert(unit_id[var(first)] == ClauseId_NULL || value(first) == l_False);    // (if variable already has 'id', it must be with the other polarity and we should have derived the empty clause here)
-                    if (value(first) != l_False)
-                        unit_id[var(first)] = id;
-                    else{
-                        // Empty clause derived:
-                        proof->beginChain(unit_id[var(first)]);
-                        proof->resolve(id, ~first);
-                        proof->endChain();
-                    }
-                }
-					 
-                *j++ = &c;
-                if (!enqueue(first, &c)){
+                if (decisionLevel() == 0 && proof != NULL)
+                    proofUnit(c);
+
+                *j++ = w;
+                if (!enqueue(first, cr)){
                     if (decisionLevel() == 0)
                         ok = false;
-                    confl = &c;
+                    confl = cr;
                     qhead = trail.size();
                     // Copy the remaining watches:
                     while (i < end)
@@ -554,6 +638,28 @@ Clause* Solver::propagate()
 }
 
 
+// Logs the production of the unit 'c[0]' by 'c' at top-level, whose other literals are all false
+// (or of the empty clause, if 'c[0]' is false as well).
+//
+void Solver::proofUnit(const Clause& c)
+{
+    Lit first = c[0];
+    proof->beginChain(c.id());
+    for (int k = 1; k < c.size(); k++)
+        proof->resolve(unit_id[var(c[k])], c[k]);
+    ClauseId id = proof->endChain();
+    assert(unit_id[var(first)] == ClauseId_NULL || value(first) == l_False);    // (if variable already has 'id', it must be with the other polarity and we should have derived the empty clause here)
+    if (value(first) != l_False)
+        unit_id[var(first)] = id;
+    else{
+        // Empty clause derived:
+        proof->beginChain(unit_id[var(first)]);
+        proof->resolve(id, ~first);
+        proof->endChain();
+    }
+}
+
+
 /*_________________________________________________________________________________________________
 |
 |  reduceDB : ()  ->  [void]
@@ -562,26 +668,133 @@ Clause* Solver::propagate()
 |    Remove half of the learnt clauses, minus the clauses locked by the current assignment. Locked
 |    clauses are clauses that are reason to some assignment. Binary clauses are never removed.
 |________________________________________________________________________________________________@*/
-struct reduceDB_lt { bool operator () (Clause* x, Clause* y) { return x->size() > 2 && (y->size() == 2 || x->activity() < y->activity()); } };
+struct reduceDB_lt {
+    const ClauseAllocator& ca;
+    reduceDB_lt(const ClauseAllocator& ca_) : ca(ca_) {}
+    bool operator () (CRef x, CRef y) { return ca[x].size() > 2 && (ca[y].size() == 2 || ca[x].activity() < ca[y].activity()); } };
 void Solver::reduceDB()
 {
     int     i, j;
     double  extra_lim = cla_inc / learnts.size();    // Remove any clause below this activity
 
-    sort(learnts, reduceDB_lt());
+    sort(learnts, reduceDB_lt(ca));
     for (i = j = 0; i < learnts.size() / 2; i++){
-        if (learnts[i]->size() > 2 && !locked(learnts[i]))
+        if (ca[learnts[i]].size() > 2 && !locked(learnts[i]))
             remove(learnts[i]);
         else
             learnts[j++] = learnts[i];
     }
     for (; i < learnts.size(); i++){
-        if (learnts[i]->size() > 2 && !locked(learnts[i]) && learnts[i]->activity() < extra_lim)
+        if (ca[learnts[i]].size() > 2 && !locked(learnts[i]) && ca[learnts[i]].activity() < extra_lim)
+            remove(learnts[i]);
+        else
+            learnts[j++] = learnts[i];
+    }
+    learnts.shrink(i - j);
+    checkGarbage();
+}
+
+
+/*_________________________________________________________________________________________________
+|
+|  reduceDB_lbd : (glue_keep : int)  ->  [void]
+|  
+|  Description:
+|    Like 'reduceDB()', but remove the half of the learnt clauses with the highest LBD (the least
+|    active first among equal LBDs). Clauses of LBD <= 'glue_keep' are never removed.
+|________________________________________________________________________________________________@*/
+struct reduceDB_lbd_lt {
+    const ClauseAllocator& ca;
+    reduceDB_lbd_lt(const ClauseAllocator& ca_) : ca(ca_) {}
+    bool operator () (CRef x, CRef y) {
+        if (ca[x].lbd() != ca[y].lbd()) return ca[x].lbd() > ca[y].lbd();
+        return ca[x].activity() < ca[y].activity(); } };
+void Solver::reduceDB_lbd(int glue_keep)
+{
+    int     i, j;
+    int     limit = learnts.size() / 2;
+
+    sort(learnts, reduceDB_lbd_lt(ca));
+    for (i = j = 0; i < learnts.size(); i++){
+        const Clause& c = ca[learnts[i]];
+        if (i < limit && c.size() > 2 && (int)c.lbd() > glue_keep && !locked(learnts[i]))
             remove(learnts[i]);
         else
             learnts[j++] = learnts[i];
     }
     learnts.shrink(i - j);
+    checkGarbage();
+}
+
+
+// The number of distinct decision levels among the (assigned) literals 'ps[0..size-1]'.
+//
+uint Solver::computeLBD(const Lit* ps, int size)
+{
+    if (++lbd_stamp == 0){      // (wrapped around: forget the old stamps)
+        lbd_level.clear();
+        lbd_stamp = 1; }
+    lbd_level.growTo(decisionLevel() + 1, 0);
+
+    uint    n = 0;
+    for (int i = 0; i < size; i++){
+        int lev = level[var(ps[i])];
+        if (lbd_level[lev] != lbd_stamp){
+            lbd_level[lev] = lbd_stamp;
+            n++; }
+    }
+    return n;
+}
+
+
+/*_________________________________________________________________________________________________
+|
+|  garbageCollect : ()  ->  [void]
+|  
+|  Description:
+|    Move the live clauses into a new region, dropping the words of the removed ones, and update
+|    every 'CRef' held by the solver. 'checkGarbage()' calls it once a 'garbage_frac' fraction of
+|    the region is waste.
+|________________________________________________________________________________________________@*/
+void Solver::checkGarbage()
+{
+    if (ca.wasted() > ca.size() * garbage_frac)
+        garbageCollect();
+}
+
+void Solver::garbageCollect()
+{
+    ClauseAllocator to;
+    to.capacity(ca.size() - ca.wasted());
+    relocAll(to);
+    to.moveTo(ca);
+}
+
+void Solver::relocAll(ClauseAllocator& to)
+{
+    // Watches:
+    for (int i = 0; i < watches.size(); i++){
+        vec<Watcher>& ws = watches[i];
+        for (int j = 0; j < ws.size(); j++)
+            ca.reloc(ws[j].cref, to);
+        vec<Watcher>& wbin = watchesBin[i];
+        for (int j = 0; j < wbin.size(); j++)
+            ca.reloc(wbin[j].cref, to);
+    }
+
+    // Reasons (only the assigned variables have one):
+    for (int i = 0; i < trail.size(); i++){
+        Var x = var(trail[i]);
+        if (reason[x] != CRef_Undef)
+            ca.reloc(reason[x], to);
+    }
+
+    // Clause lists:
+    for (int type = 0; type < 3; type++){
+        vec<CRef>& cs = type == 2 ? guarded : type ? learnts : clauses;
+        for (int i = 0; i < cs.size(); i++)
+            ca.reloc(cs[i], to);
+    }
 }
 
 
@@ -596,9 +809,9 @@ void Solver::reduceDB()
 void Solver::simplifyDB()
 {
     if (!ok) return;    // GUARD (public method)
-    assert(decisionLevel() == 0);
+    cancelUntil(0);     // (drops the assumptions left by 'keep_assumps')
 
-    if (propagate() != NULL){
+    if (propagate() != CRef_Undef){
         ok = false;
         return; }
 
@@ -608,13 +821,15 @@ void Solver::simplifyDB()
     // Clear watcher lists:
     for (int i = simpDB_assigns; i < nAssigns(); i++){
         Lit p = trail[i];
-        watches[index( p)].clear(true);
-        watches[index(~p)].clear(true);
+        watches   [index( p)].clear(true);
+        watches   [index(~p)].clear(true);
+        watchesBin[index( p)].clear(true);
+        watchesBin[index(~p)].clear(true);
     }
 
     // Remove satisfied clauses:
-    for (int type = 0; type < 2; type++){
-        vec<Clause*>& cs = type ? learnts : clauses;
+    for (int type = 0; type < 3; type++){
+        vec<CRef>&    cs = type == 2 ? guarded : type ? learnts : clauses;
         int           j  = 0;
         for (int i = 0; i < cs.size(); i++){
             if (!locked(cs[i]) && simplify(cs[i]))
@@ -625,6 +840,8 @@ void Solver::simplifyDB()
         cs.shrink(cs.size()-j);
     }
 
+    checkGarbage();
+
     simpDB_assigns = nAssigns();
     simpDB_props   = stats.clauses_literals + stats.learnts_literals;   // (shouldn't depend on 'stats' really, but it will do for now)
 }
@@ -637,7 +854,9 @@ void Solver::simplifyDB()
 |  Description:
 |    Search for a model the specified number of conflicts, keeping the number of learnt clauses
 |    below the provided limit. NOTE! Use negative value for 'nof_conflicts' or 'nof_learnts' to
-|    indicate infinity.
+|    indicate infinity. With 'params.restart == restart_Glucose', it also stops when the recent
+|    LBDs call for a restart; with 'params.lbd_reduce', the learnts are reduced on the conflict
+|    schedule of 'reduceDB_lbd()' instead of by 'nof_learnts'.
 |  
 |  Output:
 |    'l_True' if a partial assigment that is consistent with respect to the clauseset is found. If
@@ -651,13 +870,14 @@ lbool Solver::search(int nof_conflicts, int nof_learnts, const SearchParams& par
 
     stats.starts++;
     int     conflictC = 0;
-    var_decay = 1 / params.var_decay;
-    cla_decay = 1 / params.clause_decay;
+    var_decay  = 1 / params.var_decay;
+    cla_decay  = 1 / params.clause_decay;
+    lbd_update = params.lbd_reduce;
     model.clear();
 
     for (;;){
-        Clause* confl = propagate();
-        if (confl != NULL){
+        CRef confl = propagate();
+        if (confl != CRef_Undef){
             // CONFLICT
 
             stats.conflicts++; conflictC++;
@@ -668,8 +888,11 @@ lbool Solver::search(int nof_conflicts, int nof_learnts, const SearchParams& par
                 analyzeFinal(confl);
                 return l_False; }
             analyze(confl, learnt_clause, backtrack_level);
+            uint lbd = computeLBD(learnt_clause, learnt_clause.size());
+            lbd_fast += (lbd - lbd_fast) * max(1.0 / 32,    1.0 / stats.conflicts);
+            lbd_slow += (lbd - lbd_slow) * max(1.0 / 16384, 1.0 / stats.conflicts);
             cancelUntil(max(backtrack_level, root_level));
-            newClause(learnt_clause, true, (proof != NULL) ? proof->last() : ClauseId_NULL);
+            newClause(learnt_clause, true, (proof != NULL) ? proof->last() : ClauseId_NULL, true, lbd);
             if (learnt_clause.size() == 1) level[var(learnt_clause[0])] = 0;    // (this is ugly (but needed for 'analyzeFinal()') -- in future versions, we will backtrack past the 'root_level' and redo the assumptions)
             varDecayActivity();
             claDecayActivity();
@@ -677,8 +900,10 @@ lbool Solver::search(int nof_conflicts, int nof_learnts, const SearchParams& par
         }else{
             // NO CONFLICT
 
-            if (nof_conflicts >= 0 && conflictC >= nof_conflicts){
-                // Reached bound on number of conflicts:
+            if ((nof_conflicts >= 0 && conflictC >= nof_conflicts)
+             || (params.restart == restart_Glucose && conflictC >= 50 && lbd_fast * params.restart_K > lbd_slow)
+             || !withinBudget()){
+                // Reached bound on number of conflicts, restart condition (or a budget of 'solveLimited()'):
                 progress_estimate = progressEstimate();
                 cancelUntil(root_level);
                 return l_Undef; }
@@ -687,15 +912,20 @@ lbool Solver::search(int nof_conflicts, int nof_learnts, const SearchParams& par
                 // Simplify the set of problem clauses:
                 simplifyDB(), assert(ok);
 
-            if (nof_learnts >= 0 && learnts.size()-nAssigns() >= nof_learnts)
+            if (params.lbd_reduce){
+                // Reduce the set of learnt clauses every 2000 + 300*k conflicts (as Glucose does):
+                if (stats.conflicts >= next_reduce){
+                    reduceDB_lbd(params.glue_keep);
+                    next_reduce = stats.conflicts + 2000 + 300 * (++nof_reduce); }
+            }else if (nof_learnts >= 0 && learnts.size()-nAssigns() >= nof_learnts)
                 // Reduce the set of learnt clauses:
                 reduceDB();
 
             // New variable decision:
             stats.decisions++;
-            Var next = order.select(params.random_var_freq);
+            Lit next = pickBranchLit(params);
 
-            if (next == var_Undef){
+            if (next == lit_Undef){
                 // Model found:
                 model.growTo(nVars());
                 for (int i = 0; i < nVars(); i++) model[i] = value(i);
@@ -703,12 +933,52 @@ lbool Solver::search(int nof_conflicts, int nof_learnts, const SearchParams& par
                 return l_True;
             }
 
-            check(assume(~Lit(next)));
+            check(assume(next));
         }
     }
 }
 
 
+// The next decision: the most active unassigned variable (or, now and then, a random one), with
+// the sign of 'polarity[]'. 'lit_Undef' if all variables are assigned.
+//
+Lit Solver::pickBranchLit(const SearchParams& params)
+{
+    Var next = order.select(params.random_var_freq);
+    return next == var_Undef ? lit_Undef : Lit(next, polarity[next]);
+}
+
+
+// The 'x'th element (from 0) of the Luby sequence 1 1 2 1 1 2 4 1 1 2 1 1 2 4 8 ..., with 2 replaced by 'y'.
+//
+static double luby(double y, int x)
+{
+    // Find the finite subsequence that contains index 'x', and the size of that subsequence:
+    int size, seq;
+    for (size = 1, seq = 0; size < x+1; seq++, size = 2*size+1);
+
+    while (size-1 != x){
+        size = (size-1) >> 1;
+        seq--;
+        x    = x % size;
+    }
+    return pow(y, seq);
+}
+
+
+// FALSE once the current 'solveLimited()' has spent one of its budgets (and from then on).
+//
+bool Solver::withinBudget()
+{
+    if (budget_out) return false;
+    if ((conflict_limit >= 0 && stats.conflicts >= conflict_limit)
+     || (propagation_limit >= 0 && stats.propagations >= propagation_limit)
+     || (time_limit > 0 && (++time_checks & 63) == 0 && realTime() >= time_limit))
+        budget_out = true;
+    return !budget_out;
+}
+
+
 // Return search-space coverage. Not extremely reliable.
 //
 double Solver::progressEstimate()
@@ -737,41 +1007,62 @@ void Solver::varRescaleActivity()
 void Solver::claRescaleActivity()
 {
     for (int i = 0; i < learnts.size(); i++)
-        learnts[i]->activity() *= 1e-20;
+        ca[learnts[i]].activity() *= 1e-20;
     cla_inc *= 1e-20;
 }
 
 
 /*_________________________________________________________________________________________________
 |
-|  solve : (assumps : const vec<Lit>&)  ->  [bool]
+|  solveLimited : (assumps : const vec<Lit>&)  ->  [lbool]
 |  
 |  Description:
 |    Top-level solve. If using assumptions (non-empty 'assumps' vector), you must call
 |    'simplifyDB()' first to see that no top-level conflict is present (which would put the solver
-|    in an undefined state).
+|    in an undefined state). Gives up with 'l_Undef' once 'conflict_budget' conflicts,
+|    'propagation_budget' propagations or 'time_budget' seconds (those that are set) are spent;
+|    'solve()' is this with no budget set.
+|  
+|    With 'keep_assumps', the assumptions stay assigned at the end (unless UNSAT), and the next
+|    call keeps the levels of the assumptions it shares with this one from the start, instead of
+|    assigning and propagating them again. As nothing changed at top-level in between (adding or
+|    removing clauses drops the levels), 'simplifyDB()' is skipped then.
 |  
 |  Input:
 |    A list of assumptions (unit clauses coded as literals). Pre-condition: The assumptions must
 |    not contain both 'x' and '~x' for any variable 'x'.
 |________________________________________________________________________________________________@*/
-bool Solver::solve(const vec<Lit>& assumps)
+lbool Solver::solveLimited(const vec<Lit>& assumps)
 {
-    simplifyDB();
-    if (!ok) return false;
+    // Levels left by the last call for the first assumptions of this one:
+    int keep = 0;
+    while (keep < decisionLevel() && keep < assumps.size() && root_assumps[keep] == assumps[keep])
+        keep++;
+    cancelUntil(keep);
+    if (keep == 0){
+        simplifyDB();
+        if (!ok) return l_False; }
+
+    conflict_limit    = (conflict_budget < 0)    ? -1 : stats.conflicts    + conflict_budget;
+    propagation_limit = (propagation_budget < 0) ? -1 : stats.propagations + propagation_budget;
+    time_limit        = (time_budget <= 0)       ? 0  : realTime() + time_budget;
+    time_checks       = 0;
+    budget_out        = false;
 
     SearchParams    params(default_params);
-    double  nof_conflicts = 100;
+    double  nof_conflicts = params.restart_first;
     double  nof_learnts   = nClauses() / 3;
+    int     nof_restarts  = 0;
     lbool   status        = l_Undef;
 
     // Perform assumptions:
     root_level = assumps.size();
-    for (int i = 0; i < assumps.size(); i++){
+    assumps.copyTo(root_assumps);
+    for (int i = keep; i < assumps.size(); i++){
         Lit p = assumps[i];
         assert(var(p) < nVars());
         if (!assume(p)){
-            if (reason[var(p)] != NULL){
+            if (reason[var(p)] != CRef_Undef){
                 analyzeFinal(reason[var(p)], true);
                 conflict.push(~p);
             }else{
@@ -781,12 +1072,12 @@ bool Solver::solve(const vec<Lit>& assumps)
                 if (proof != NULL) conflict_id = unit_id[var(p)];
             }
             cancelUntil(0);
-            return false; }
-        Clause* confl = propagate();
-        if (confl != NULL){
+            return l_False; }
+        CRef confl = propagate();
+        if (confl != CRef_Undef){
             analyzeFinal(confl), assert(conflict.size() > 0);
             cancelUntil(0);
-            return false; }
+            return l_False; }
     }
     assert(root_level == decisionLevel());
 
@@ -802,7 +1093,7 @@ bool Solver::solve(const vec<Lit>& assumps)
         reportf("===================================\n");
     }
 
-    while (status == l_Undef){
+    while (status == l_Undef && withinBudget()){
         if (verbosity >= 1){
             printStats();
             reportf("| %9d | %7d %8d | %7d %7d %8d %7.1f | %6.3f %% |\n",
@@ -814,8 +1105,13 @@ bool Solver::solve(const vec<Lit>& assumps)
                    progress_estimate*100);
             fflush(stdout);
         }
-        status = search((int)nof_conflicts, (int)nof_learnts, params);
-        nof_conflicts *= 1.5;
+        int     restart_conflicts =
+                    params.restart == restart_Glucose ? -1
+                  : params.restart == restart_Luby    ? (int)(luby(params.restart_inc, nof_restarts) * params.restart_first)
+                  :                                     (int)nof_conflicts;
+        status = search(restart_conflicts, (int)nof_learnts, params);
+        nof_restarts++;
+        nof_conflicts *= params.restart_inc;
         nof_learnts   *= 1.1;
     }
     if (verbosity >= 1) {
@@ -823,8 +1119,9 @@ bool Solver::solve(const vec<Lit>& assumps)
         reportf("===================================\n");
     }
 
-    cancelUntil(0);
-    return status == l_True;
+    if (!keep_assumps || status == l_False)
+        cancelUntil(0);
+    return status;
 }
 
 void Solver::printStats()
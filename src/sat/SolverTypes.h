@@ -82,35 +82,116 @@ const   int ClauseId_NULL = INT_MIN;
 //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 
 class Clause {
-    uint    size_learnt;
+    uint    header;     // size << 3 | relocated << 2 | has_id << 1 | learnt
     Lit     data[1];
 public:
     // NOTE: This constructor cannot be used directly (doesn't allocate enough memory).
     Clause(bool learnt, const vec<Lit>& ps, ClauseId id_ = ClauseId_NULL) {
-        size_learnt = (ps.size() << 1) | (int)learnt;
+        header = (ps.size() << 3) | ((int)(id_ != ClauseId_NULL) << 1) | (int)learnt;
         for (int i = 0; i < ps.size(); i++) data[i] = ps[i];
-        if (learnt) activity() = 0;
+        if (learnt) activity() = 0, lbd() = 0;
         if (id_ != ClauseId_NULL) id() = id_; }
 
-    // -- use this function instead:
-    friend Clause* Clause_new(bool, const vec<Lit>&, ClauseId);
+    // -- use 'ClauseAllocator::alloc()' instead.
 
-    int       size        ()      const { return size_learnt >> 1; }
-    bool      learnt      ()      const { return size_learnt & 1; }
+    int       size        ()      const { return header >> 3; }
+    bool      learnt      ()      const { return header & 1; }
+    bool      hasId       ()      const { return header & 2; }
+    int       words       ()      const { return 1 + size() + 2*(int)learnt() + (int)hasId(); }  // (in 32-bit words)
     Lit       operator [] (int i) const { return data[i]; }
     Lit&      operator [] (int i)       { return data[i]; }
     float&    activity    ()      const {
         void *p = const_cast<Lit*>(&data[size()]); return *((float *)p);
     } //              return *((float*)&data[size()]); }
-    ClauseId& id          ()      const { return *((ClauseId*)&data[size() + (int)learnt()]); }
+    uint&     lbd         ()      const { return *((uint*)&data[size() + 1]); }    // (learnt only) distinct decision levels, or "glue"
+    ClauseId& id          ()      const { return *((ClauseId*)&data[size() + 2*(int)learnt()]); }
+
+    // Set by garbage collection once the clause is copied; the copy's reference then replaces 'data[0]'.
+    bool      relocated   ()      const { return header & 4; }
+    uint      relocation  ()      const { return *((uint*)&data[0]); }
+    void      relocate    (uint r)      { header |= 4; *((uint*)&data[0]) = r; }
+};
+
+
+//=================================================================================================
+// ClauseAllocator -- one region holding all clauses; a clause is named by its 32-bit offset:
+
+
+typedef uint CRef;
+const   CRef CRef_Undef = UINT_MAX;
+
+class ClauseAllocator {
+    uint*   memory;
+    uint    sz;
+    uint    cap;
+    uint    wasted_;    // Words of freed clauses; reclaimed only by moving the live ones to a new region.
+
+    void    grow(uint min_cap) {
+        if (min_cap <= cap) return;
+        uint64 c = cap == 0 ? 1024 : cap;
+        while (c < min_cap) c += (c >> 1) + 2;
+        assert(c < (uint64)CRef_Undef);
+        cap    = (uint)c;
+        memory = xrealloc(memory, cap); }
+
+public:
+    ClauseAllocator() : memory(NULL), sz(0), cap(0), wasted_(0) { }
+   ~ClauseAllocator() { xfree(memory); }
+
+    uint     size      () const        { return sz; }
+    uint     wasted    () const        { return wasted_; }
+    void     capacity  (uint min_cap)  { grow(min_cap); }
+
+    // NOTE! May move the region; a 'Clause&' or 'Clause*' taken before does not survive this call.
+    CRef alloc(bool learnt, const vec<Lit>& ps, ClauseId id = ClauseId_NULL) {
+        assert(sizeof(Lit)      == sizeof(uint));
+        assert(sizeof(float)    == sizeof(uint));
+        assert(sizeof(ClauseId) == sizeof(uint));
+        uint    words = 1 + ps.size() + 2*(int)learnt + (int)(id != ClauseId_NULL);
+        grow(sz + words);
+        CRef    r = sz;
+        sz += words;
+        new (&memory[r]) Clause(learnt, ps, id);
+        return r; }
+    void     free      (CRef r)        { wasted_ += (*this)[r].words(); }
+
+    Clause&       operator [] (CRef r)       { return *(Clause*)&memory[r]; }
+    const Clause& operator [] (CRef r) const { return *(const Clause*)&memory[r]; }
+
+    // Moves the clause 'r' to 'to' (once; later calls just look up the copy) and updates 'r'.
+    void reloc(CRef& r, ClauseAllocator& to) {
+        Clause& c = (*this)[r];
+        if (c.relocated()){ r = c.relocation(); return; }
+        uint    words = c.words();
+        to.grow(to.sz + words);
+        CRef    n = to.sz;
+        to.sz += words;
+        memcpy(&to.memory[n], &c, words * sizeof(uint));
+        c.relocate(n);
+        r = n; }
+
+    void moveTo(ClauseAllocator& to) {
+        xfree(to.memory);
+        to.memory = memory; to.sz = sz; to.cap = cap; to.wasted_ = wasted_;
+        memory = NULL; sz = cap = wasted_ = 0; }
+
+private:
+    ClauseAllocator(const ClauseAllocator&);                // not copyable
+    ClauseAllocator& operator = (const ClauseAllocator&);
 };
 
-inline Clause* Clause_new(bool learnt, const vec<Lit>& ps, ClauseId id = ClauseId_NULL) {
-    assert(sizeof(Lit)      == sizeof(uint));
-    assert(sizeof(float)    == sizeof(uint));
-    assert(sizeof(ClauseId) == sizeof(uint));
-    void*   mem = xmalloc<char>(sizeof(Clause) + sizeof(uint)*(ps.size() + (int)learnt + (int)(id != ClauseId_NULL)));
-    return new (mem) Clause(learnt, ps, id); }
+
+//=================================================================================================
+// Watcher -- an entry of a watch list:
+
+
+// 'blocker' is some literal of the clause other than the watched one; while it is true, the clause
+// is satisfied and 'propagate()' need not look at it. For a binary clause it is the other literal.
+struct Watcher {
+    CRef    cref;
+    Lit     blocker;
+    Watcher(CRef cr, Lit p) : cref(cr), blocker(p) {}
+};
 
 
 //=================================================================================================
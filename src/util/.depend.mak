@@ -1,3 +0,0 @@
-myGetChar.o: myGetChar.cpp
-myString.o: myString.cpp
-util.o: util.cpp rnGen.h myUsage.h
@@ -1,4 +1,4 @@
-util.d: ../../include/util.h ../../include/rnGen.h ../../include/myUsage.h ../../include/myHash.h 
+util.d: ../../include/util.h ../../include/rnGen.h ../../include/myUsage.h ../../include/myHash.h ../../include/myThreadPool.h ../../include/myMappedFile.h 
 ../../include/util.h: util.h
 	@rm -f ../../include/util.h
 	@ln -fs ../src/util/util.h ../../include/util.h
@@ -11,3 +11,9 @@ util.d: ../../include/util.h ../../include/rnGen.h ../../include/myUsage.h ../..
 ../../include/myHash.h: myHash.h
 	@rm -f ../../include/myHash.h
 	@ln -fs ../src/util/myHash.h ../../include/myHash.h
+../../include/myThreadPool.h: myThreadPool.h
+	@rm -f ../../include/myThreadPool.h
+	@ln -fs ../src/util/myThreadPool.h ../../include/myThreadPool.h
+../../include/myMappedFile.h: myMappedFile.h
+	@rm -f ../../include/myMappedFile.h
+	@ln -fs ../src/util/myMappedFile.h ../../include/myMappedFile.h
@@ -0,0 +1,133 @@
+/****************************************************************************
+  FileName     [ myAsyncWriter.cpp ]
+  PackageName  [ util ]
+  Synopsis     [ Define the double-buffered file writer ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2007-2013 LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include "myAsyncWriter.h"
+
+using namespace std;
+
+static bool
+writeAll(int fd, const char* p, size_t n)
+{
+   while (n > 0) {
+      ssize_t w = ::write(fd, p, n);
+      if (w <= 0) return false;
+      p += w; n -= w;
+   }
+   return true;
+}
+
+//----------------------------------------------------------------------
+//    class AsyncWriter member functions
+//----------------------------------------------------------------------
+AsyncWriter::AsyncWriter(size_t bufSize)
+   : _fd(-1), _cur(0), _used(0), _pending(false), _pendingSize(0),
+     _stop(false), _failed(false)
+{
+   _buf[0].resize(bufSize);
+   _buf[1].resize(bufSize);
+   pthread_mutex_init(&_lock, 0);
+   pthread_cond_init(&_cond, 0);
+}
+
+AsyncWriter::~AsyncWriter()
+{
+   close();
+   pthread_cond_destroy(&_cond);
+   pthread_mutex_destroy(&_lock);
+}
+
+bool
+AsyncWriter::open(const string& fileName)
+{
+   close();
+   _fd = ::open(fileName.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+   if (_fd < 0) return false;
+   _cur = 0; _used = 0;
+   _pending = false; _stop = false; _failed = false;
+   if (pthread_create(&_thread, 0, writerMain, this) != 0) {
+      ::close(_fd); _fd = -1;
+      return false;
+   }
+   return true;
+}
+
+char*
+AsyncWriter::reserve(size_t n)
+{
+   if (_used + n > _buf[_cur].size()) {
+      handOver();
+      // the buffer now filled is not the thread's any more
+      if (n > _buf[_cur].size()) _buf[_cur].resize(n);
+   }
+   return &_buf[_cur][0] + _used;
+}
+
+void
+AsyncWriter::write(const void* p, size_t n)
+{
+   memcpy(reserve(n), p, n);
+   commit(n);
+}
+
+// Gives the filled buffer to the thread, once it is done with the other
+void
+AsyncWriter::handOver()
+{
+   pthread_mutex_lock(&_lock);
+   while (_pending)
+      pthread_cond_wait(&_cond, &_lock);
+   if (_used != 0) {
+      _pending = true;
+      _pendingSize = _used;
+      _cur = 1 - _cur;
+      _used = 0;
+      pthread_cond_broadcast(&_cond);
+   }
+   pthread_mutex_unlock(&_lock);
+}
+
+bool
+AsyncWriter::close(const void* head, size_t n)
+{
+   if (_fd < 0) return !_failed;
+   handOver();
+   pthread_mutex_lock(&_lock);
+   _stop = true;
+   pthread_cond_broadcast(&_cond);
+   pthread_mutex_unlock(&_lock);
+   pthread_join(_thread, 0);
+   if (head && n != 0 && pwrite(_fd, head, n, 0) != ssize_t(n))
+      _failed = true;
+   if (::close(_fd) != 0) _failed = true;
+   _fd = -1;
+   return !_failed;
+}
+
+void*
+AsyncWriter::writerMain(void* p)
+{
+   AsyncWriter* w = (AsyncWriter*)p;
+   pthread_mutex_lock(&(w->_lock));
+   while (true) {
+      while (!w->_pending && !w->_stop)
+         pthread_cond_wait(&(w->_cond), &(w->_lock));
+      if (!w->_pending) break;
+      const char* data = &(w->_buf[1 - w->_cur][0]);
+      size_t n = w->_pendingSize;
+      pthread_mutex_unlock(&(w->_lock));
+      bool ok = writeAll(w->_fd, data, n);
+      pthread_mutex_lock(&(w->_lock));
+      if (!ok) w->_failed = true;
+      w->_pending = false;
+      pthread_cond_broadcast(&(w->_cond));
+   }
+   pthread_mutex_unlock(&(w->_lock));
+   return 0;
+}
@@ -0,0 +1,153 @@
+/****************************************************************************
+  FileName     [ myThreadPool.cpp ]
+  PackageName  [ util ]
+  Synopsis     [ Define the work-stealing thread pool ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2007-2013 LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+#include <cassert>
+#include "myThreadPool.h"
+
+using namespace std;
+
+//----------------------------------------------------------------------
+//    class ThreadPool member functions
+//----------------------------------------------------------------------
+ThreadPool::ThreadPool()
+   : _size(1), _next(0), _queued(0), _unfinished(0), _stop(false)
+{
+   pthread_mutex_init(&_lock, 0);
+   pthread_cond_init(&_work, 0);
+   pthread_cond_init(&_done, 0);
+}
+
+ThreadPool::~ThreadPool()
+{
+   stop();
+   pthread_cond_destroy(&_done);
+   pthread_cond_destroy(&_work);
+   pthread_mutex_destroy(&_lock);
+}
+
+void
+ThreadPool::start(unsigned n)
+{
+   stop();
+   _size = (n < 1)? 1: n;
+   if (_size < 2) return;
+
+   _stop = false;
+   _workers.resize(_size);
+   for (unsigned i = 0; i < _size; ++i) {
+      _workers[i] = new Worker;
+      _workers[i]->_pool = this;
+      _workers[i]->_id = i;
+      pthread_mutex_init(&(_workers[i]->_lock), 0);
+   }
+   for (unsigned i = 0; i < _size; ++i)
+      pthread_create(&(_workers[i]->_thread), 0, workerMain, _workers[i]);
+}
+
+void
+ThreadPool::stop()
+{
+   if (_workers.empty()) return;
+   wait();
+   pthread_mutex_lock(&_lock);
+   _stop = true;
+   pthread_cond_broadcast(&_work);
+   pthread_mutex_unlock(&_lock);
+   for (size_t i = 0; i < _workers.size(); ++i)
+      pthread_join(_workers[i]->_thread, 0);
+   for (size_t i = 0; i < _workers.size(); ++i) {
+      pthread_mutex_destroy(&(_workers[i]->_lock));
+      delete _workers[i];
+   }
+   _workers.clear();
+   _size = 1;
+}
+
+void
+ThreadPool::push(ThreadTask* t)
+{
+   if (_workers.empty()) { t->run(0); return; }
+
+   // count the task first so that finish() never sees it uncounted
+   pthread_mutex_lock(&_lock);
+   ++_queued;
+   ++_unfinished;
+   pthread_mutex_unlock(&_lock);
+
+   Worker* w = _workers[_next];
+   if (++_next == _workers.size()) _next = 0;
+   pthread_mutex_lock(&(w->_lock));
+   w->_tasks.push_back(t);
+   pthread_mutex_unlock(&(w->_lock));
+
+   pthread_mutex_lock(&_lock);
+   pthread_cond_signal(&_work);
+   pthread_mutex_unlock(&_lock);
+}
+
+void
+ThreadPool::wait()
+{
+   pthread_mutex_lock(&_lock);
+   while (_unfinished != 0)
+      pthread_cond_wait(&_done, &_lock);
+   pthread_mutex_unlock(&_lock);
+}
+
+void*
+ThreadPool::workerMain(void* p)
+{
+   Worker* w = (Worker*)p;
+   ThreadPool* pool = w->_pool;
+   while (true) {
+      ThreadTask* t = pool->take(w->_id);
+      if (t) {
+         t->run(w->_id);
+         pool->finish();
+         continue;
+      }
+      pthread_mutex_lock(&(pool->_lock));
+      while (!pool->_stop && pool->_queued <= 0)
+         pthread_cond_wait(&(pool->_work), &(pool->_lock));
+      bool quit = pool->_stop && pool->_queued <= 0;
+      pthread_mutex_unlock(&(pool->_lock));
+      if (quit) break;
+   }
+   return 0;
+}
+
+// Own deque first (newest task), then steal the oldest from the others
+ThreadTask*
+ThreadPool::take(unsigned id)
+{
+   ThreadTask* t = 0;
+   for (unsigned k = 0; k < _size && !t; ++k) {
+      Worker* w = _workers[(id + k) % _size];
+      pthread_mutex_lock(&(w->_lock));
+      if (!w->_tasks.empty()) {
+         if (k == 0) { t = w->_tasks.back(); w->_tasks.pop_back(); }
+         else { t = w->_tasks.front(); w->_tasks.pop_front(); }
+      }
+      pthread_mutex_unlock(&(w->_lock));
+   }
+   if (t) {
+      pthread_mutex_lock(&_lock);
+      --_queued;
+      pthread_mutex_unlock(&_lock);
+   }
+   return t;
+}
+
+void
+ThreadPool::finish()
+{
+   pthread_mutex_lock(&_lock);
+   assert(_unfinished > 0);
+   if (--_unfinished == 0)
+      pthread_cond_broadcast(&_done);
+   pthread_mutex_unlock(&_lock);
+}
@@ -26,5 +26,27 @@ class RandomNumGen
       }
 };
 
+// Reentrant xorshift64* generator keeping its own state, so that every
+// thread can own one (RandomNumGen above shares the state of random())
+class LocalRandomNumGen
+{
+   public:
+      LocalRandomNumGen(unsigned seed = 0) { reset(seed); }
+      void reset(unsigned seed) {
+         _state = 0x9e3779b97f4a7c15ULL * (seed + 1ULL);
+      }
+      unsigned long long next() {
+         _state ^= _state >> 12;
+         _state ^= _state << 25;
+         _state ^= _state >> 27;
+         return _state * 2685821657736338717ULL;
+      }
+      const int operator() (const int range) {
+         return int(range * (double(next() >> 33) / 2147483648.0));
+      }
+   private:
+      unsigned long long _state;
+};
+
 #endif // RN_GEN_H
 
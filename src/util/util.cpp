@@ -26,6 +26,8 @@ size_t getHashSize(size_t s) {
    if (s < 8192) return 4999;
    if (s < 32768) return 13999;
    if (s < 131073) return 59999;
-   return 71993;
+   if (s < 524288) return 262139;
+   if (s < 2097152) return 1048573;
+   return 4194301;
 }
 